@@ -0,0 +1,113 @@
+// Simulation only top with every pattern of Monitor_Tester behind a select input, used by the frame hash
+// regression tests (tests/gpu/frame_hash_test.cpp)
+module Pattern_Tester(
+   clk,
+   pattern,
+   fill_red,
+   fill_green,
+   fill_blue,
+   red,
+   blue,
+   green,
+   hsync,
+   vsync
+);
+localparam PATTERN_GRADIENT = 3'd0;
+localparam PATTERN_GRID = 3'd1;
+localparam PATTERN_TV = 3'd2;
+localparam PATTERN_BOUNCING_SQUARE = 3'd3;
+localparam PATTERN_FILL_COLOR = 3'd4;
+
+input  clk;
+input  [2:0] pattern;
+input  [3:0] fill_red;
+input  [3:0] fill_green;
+input  [3:0] fill_blue;
+output [3:0] red;
+output [3:0] blue;
+output [3:0] green;
+output hsync;
+output vsync;
+
+wire canDisplayImage;
+wire [9:0] x;
+wire [9:0] y;
+
+wire [3:0] gradient_red, gradient_green, gradient_blue;
+wire [3:0] grid_red, grid_green, grid_blue;
+wire [3:0] tv_red, tv_green, tv_blue;
+wire [3:0] square_red, square_green, square_blue;
+wire [3:0] fill_red1, fill_green1, fill_blue1;
+
+VGA vga_inst(
+    .clk(clk),
+    .vsync(vsync),
+    .hsync(hsync),
+    .canDisplayImage(canDisplayImage),
+    .x(x),
+    .y(y)
+);
+
+gradient gradient_inst(
+    .canDisplayImage(canDisplayImage),
+    .x(x),
+    .y(y),
+    .red(gradient_red),
+    .green(gradient_green),
+    .blue(gradient_blue)
+);
+
+gridPattern grid_inst(
+    .x(x),
+    .y(y),
+    .red(grid_red),
+    .green(grid_green),
+    .blue(grid_blue)
+);
+
+tvPattern tv_inst(
+    .x(x),
+    .y(y),
+    .red(tv_red),
+    .green(tv_green),
+    .blue(tv_blue)
+);
+
+bouncingSquare square_inst(
+    .clk(clk),
+    .x(x),
+    .y(y),
+    .red(square_red),
+    .green(square_green),
+    .blue(square_blue)
+);
+
+fillColorPattern fill_inst(
+    .redLevel(fill_red),
+    .greenLevel(fill_green),
+    .blueLevel(fill_blue),
+    .red(fill_red1),
+    .green(fill_green1),
+    .blue(fill_blue1)
+);
+
+reg [3:0] red1;
+reg [3:0] green1;
+reg [3:0] blue1;
+
+always @(*)
+begin
+    case (pattern)
+        PATTERN_GRADIENT: begin red1 = gradient_red; green1 = gradient_green; blue1 = gradient_blue; end
+        PATTERN_GRID: begin red1 = grid_red; green1 = grid_green; blue1 = grid_blue; end
+        PATTERN_TV: begin red1 = tv_red; green1 = tv_green; blue1 = tv_blue; end
+        PATTERN_BOUNCING_SQUARE: begin red1 = square_red; green1 = square_green; blue1 = square_blue; end
+        default: begin red1 = fill_red1; green1 = fill_green1; blue1 = fill_blue1; end
+    endcase
+end
+
+assign red = canDisplayImage ? red1 : 4'hF;
+assign green = canDisplayImage ? green1 : 4'hF;
+assign blue = canDisplayImage ? blue1 : 4'hF;
+
+endmodule
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Minimal benchmark harness for sim_bench.
+//
+//   BENCHMARK("module/case") {
+//       ... setup, not measured ...
+//       state.run([&] { ... one operation ... });
+//   }
+//
+// The harness reruns each benchmark with more iterations until it runs for at least `--min-time`. A benchmark whose
+// setup fails calls `state.fail("why")` instead of `state.run`, it is reported as failed and not rerun.
+
+namespace bench {
+    struct State {
+        uint64_t iterations = 1u;
+        double elapsed_ns = 0.0;
+        std::optional<std::string> failure{};
+
+        void fail(std::string reason) { failure = std::move(reason); }
+
+        template <typename F> void run(F &&operation) {
+            const auto start = std::chrono::steady_clock::now();
+            for (auto i = uint64_t{0}; i < iterations; i++) {
+                operation();
+            }
+            elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        }
+    };
+
+    using BenchmarkFunction = void (*)(State &);
+
+    struct Benchmark {
+        std::string name;
+        BenchmarkFunction function;
+    };
+
+    inline auto registry() -> std::vector<Benchmark> & {
+        static auto benchmarks = std::vector<Benchmark>{};
+        return benchmarks;
+    }
+
+    struct Registrar {
+        Registrar(const char *name, BenchmarkFunction function) { registry().push_back({name, function}); }
+    };
+
+    // Keeps the compiler from optimizing away a value that is otherwise unused
+    template <typename T> inline void do_not_optimize(const T &value) {
+#if defined(_MSC_VER)
+        static volatile const T *sink;
+        sink = &value;
+#else
+        asm volatile("" : : "r,m"(value) : "memory");
+#endif
+    }
+
+    // Reads `key` of every result from a file written by sim_bench or sim_workloads --output, these write one
+    // result per line, e.g. `{"name": "cpu/clocked", "iterations": 100, "ns_per_op": 12.5}`
+    inline auto read_baseline(const std::string &path, std::string_view key) -> std::unordered_map<std::string, double> {
+        auto baseline = std::unordered_map<std::string, double>{};
+        auto file = std::ifstream{path};
+
+        constexpr auto name_key = std::string_view{"\"name\": \""};
+        const auto value_key = "\"" + std::string{key} + "\": ";
+
+        for (auto line = std::string{}; std::getline(file, line);) {
+            const auto name_pos = line.find(name_key);
+            const auto value_pos = line.find(value_key);
+            if (name_pos == std::string::npos || value_pos == std::string::npos) {
+                continue;
+            }
+
+            const auto name_start = name_pos + name_key.size();
+            const auto name = line.substr(name_start, line.find('"', name_start) - name_start);
+            baseline[name] = std::strtod(line.c_str() + value_pos + value_key.size(), nullptr);
+        }
+
+        return baseline;
+    }
+}
+
+#define BENCH_CONCAT_IMPL(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_IMPL(a, b)
+
+#define BENCHMARK_IMPL(name, function)                                                                                 \
+    static void function(bench::State &state);                                                                         \
+    static const bench::Registrar BENCH_CONCAT(function, _registrar){name, function};                                  \
+    static void function(bench::State &state)
+
+#define BENCHMARK(name) BENCHMARK_IMPL(name, BENCH_CONCAT(benchmark_, __COUNTER__))
@@ -0,0 +1,118 @@
+#include "Vmem_unit.h"
+#include "bus_trace.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <fmt/base.h>
+#include <string_view>
+
+// bus_replay TRACE [--min-time SECONDS]
+//
+// Replays a trace recorded with `sim_workloads --bus-trace` against the memory unit alone, checks that every read
+// returns what the CPU saw and measures transactions/s. The CPU is not simulated, so this isolates the cost of the
+// memory model. The trace starts with the workload's program and data (see bus_trace::preload), every pass stores
+// them into a fresh memory unit first. Reads of memory mapped devices (e.g. the keyboard port) are expected to
+// mismatch.
+
+// Drives Vmem_unit like the control unit does, see tests/cpu/mem_unit_helpers.hpp
+struct MemUnitBackend {
+    Vmem_unit mem{};
+
+    MemUnitBackend() { idle(); }
+
+    void load_mar(uint16_t address) {
+        mem.address = address;
+        mem.reg_mar_load = 1;
+        mem.eval();
+        idle();
+    }
+
+    void load_mbr(uint8_t data) {
+        mem.data_in = data;
+        mem.data_in_en = 1;
+        mem.reg_mbr_load = 1;
+        mem.eval();
+        idle();
+    }
+
+    auto read(bool zero_page, bool mem_part) -> uint8_t {
+        mem.zero_page = zero_page;
+        mem.mem_part = mem_part;
+        mem.reg_mbr_word_dir = 0;
+        mem.mem_out = 0;
+        mem.eval();
+        const auto data = static_cast<uint8_t>(mem.data_out);
+        idle();
+        return data;
+    }
+
+    void write(bool zero_page, bool mem_part) {
+        mem.zero_page = zero_page;
+        mem.mem_part = mem_part;
+        mem.mem_in = 0;
+        mem.eval();
+        idle();
+    }
+
+  private:
+    void idle() {
+        mem.zero_page = 1;
+        mem.mem_part = 0;
+        mem.mem_out = 1;
+        mem.mem_in = 1;
+        mem.reg_mbr_load = 0;
+        mem.reg_mar_load = 0;
+        mem.reg_mbr_word_dir = 1;
+        mem.data_in_en = 0;
+        mem.eval();
+    }
+};
+
+static_assert(bus_trace::MemoryBackend<MemUnitBackend>);
+
+auto main(int argc, char **argv) -> int {
+    if (argc < 2) {
+        fmt::println(stderr, "usage: {} TRACE [--min-time SECONDS]", argv[0]);
+        return 2;
+    }
+
+    auto min_time = 0.5;
+    for (auto i = 2; i < argc; i++) {
+        if (std::string_view{argv[i]} == "--min-time" && i + 1 < argc) {
+            min_time = std::strtod(argv[++i], nullptr);
+        } else {
+            fmt::println(stderr, "unknown or incomplete argument: {}", argv[i]);
+            return 2;
+        }
+    }
+
+    const auto trace = bus_trace::read(argv[1]);
+    if (!trace) {
+        fmt::println(stderr, "{} is not a bus trace", argv[1]);
+        return 2;
+    }
+
+    // a fresh memory unit per pass, so every pass checks the reads against the same memory contents
+    auto backend = MemUnitBackend{};
+    const auto checked = bus_trace::replay(*trace, backend);
+    if (checked.first_mismatch) {
+        const auto &first = *checked.first_mismatch;
+        fmt::println("{} of {} transactions mismatched, first at cycle {}: read of {:04x}, trace has {:02x}",
+                     checked.mismatches, checked.transactions, first.cycle, first.address, first.data);
+    } else {
+        fmt::println("{} transactions, all reads match", checked.transactions);
+    }
+
+    auto passes = uint64_t{0};
+    auto transactions = uint64_t{0};
+    auto seconds = 0.0;
+    while (seconds < min_time || passes == 0u) {
+        auto pass_backend = MemUnitBackend{};
+        const auto start = std::chrono::steady_clock::now();
+        transactions += bus_trace::replay(*trace, pass_backend).transactions;
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        passes++;
+    }
+
+    fmt::println("{:.0f} transactions/s over {} passes", static_cast<double>(transactions) / seconds, passes);
+    return checked.mismatches == 0u ? 0 : 1;
+}
@@ -0,0 +1,306 @@
+#include "Valu.h"
+#include "Vcontrol_unit.h"
+#include "Vcounter.h"
+#include "Vcpu.h"
+#include "Vcpu___024root.h"
+#include "Vcpu_mux.h"
+#include "Vcpu_mux___024root.h"
+#include "Vmem_unit.h"
+#include "Vram.h"
+#include "Vregister.h"
+#include "Vshift_reg.h"
+#include "Vtmp.h"
+#include "bench.hpp"
+#include "cpu_system.hpp"
+#include "mem_unit_helpers.hpp"
+
+// For every module:
+//  <module>/eval    - eval() with inputs changing between calls, so the model has to settle each time
+//  <module>/clocked - one full clock period (posedge + negedge eval)
+//  <module>/reset   - constructing the model and settling it for the first time
+
+BENCHMARK("counter/eval") {
+    Vcounter counter{};
+    auto value = uint8_t{0};
+    state.run([&] {
+        counter.in = value++;
+        counter.write = value & 1;
+        counter.eval();
+        bench::do_not_optimize(counter.out);
+    });
+}
+
+BENCHMARK("counter/clocked") {
+    Vcounter counter{};
+    counter.write = 0;
+    counter.reset = 0;
+    counter.countdown = 0;
+    state.run([&] {
+        counter.clk = 1;
+        counter.eval();
+        counter.clk = 0;
+        counter.eval();
+        bench::do_not_optimize(counter.out);
+    });
+}
+
+BENCHMARK("counter/reset") {
+    state.run([&] {
+        Vcounter counter{};
+        counter.eval();
+        bench::do_not_optimize(counter.out);
+    });
+}
+
+BENCHMARK("register/eval") {
+    Vregister reg{};
+    auto value = uint8_t{0};
+    state.run([&] {
+        reg.data_in = value++;
+        reg.enable = value & 1;
+        reg.eval();
+        bench::do_not_optimize(reg.data_out);
+    });
+}
+
+BENCHMARK("register/clocked") {
+    Vregister reg{};
+    reg.enable = 1;
+    auto value = uint8_t{0};
+    state.run([&] {
+        reg.data_in = value++;
+        reg.clk = 1;
+        reg.eval();
+        reg.clk = 0;
+        reg.eval();
+        bench::do_not_optimize(reg.data_out);
+    });
+}
+
+BENCHMARK("register/reset") {
+    state.run([&] {
+        Vregister reg{};
+        reg.eval();
+        bench::do_not_optimize(reg.data_out);
+    });
+}
+
+BENCHMARK("shift_reg/eval") {
+    Vshift_reg shift_reg{};
+    auto value = uint8_t{0};
+    state.run([&] {
+        shift_reg.data_in = value++;
+        shift_reg.data_in_enable = value & 1;
+        shift_reg.eval();
+        bench::do_not_optimize(shift_reg.data_out);
+    });
+}
+
+BENCHMARK("shift_reg/clocked") {
+    Vshift_reg shift_reg{};
+    shift_reg.data_in_enable = 0;
+    shift_reg.shift_enable = 1;
+    state.run([&] {
+        shift_reg.clk = 1;
+        shift_reg.eval();
+        shift_reg.clk = 0;
+        shift_reg.eval();
+        bench::do_not_optimize(shift_reg.data_out);
+    });
+}
+
+BENCHMARK("shift_reg/reset") {
+    state.run([&] {
+        Vshift_reg shift_reg{};
+        shift_reg.eval();
+        bench::do_not_optimize(shift_reg.data_out);
+    });
+}
+
+// The ALU is purely combinational, so it has no clocked benchmark
+BENCHMARK("alu/eval") {
+    Valu alu{};
+    alu.alu_out = 0;
+    alu.reg_f_out = 1;
+    alu.reg_f_load = 0;
+    auto value = uint8_t{0};
+    state.run([&] {
+        alu.opcode = value & 0x1F;
+        alu.reg_a = value;
+        alu.reg_b = static_cast<uint8_t>(value * 7u);
+        value++;
+        alu.eval();
+        bench::do_not_optimize(alu.data_out);
+    });
+}
+
+BENCHMARK("alu/reset") {
+    state.run([&] {
+        Valu alu{};
+        alu.eval();
+        bench::do_not_optimize(alu.data_out);
+    });
+}
+
+BENCHMARK("control_unit/eval") {
+    Vcontrol_unit control_unit{};
+    control_unit.rst = 1;
+    auto value = uint8_t{0};
+    state.run([&] {
+        control_unit.data = value++;
+        control_unit.eval();
+        bench::do_not_optimize(control_unit.signals);
+    });
+}
+
+BENCHMARK("control_unit/clocked") {
+    Vcontrol_unit control_unit{};
+    control_unit.rst = 1;
+    control_unit.reg_ir_load_override = 0;
+    control_unit.mcc_rst_override = 0;
+    state.run([&] {
+        control_unit.clk = 1;
+        control_unit.not_clk = 0;
+        control_unit.eval();
+        control_unit.clk = 0;
+        control_unit.not_clk = 1;
+        control_unit.eval();
+        bench::do_not_optimize(control_unit.signals);
+    });
+}
+
+BENCHMARK("control_unit/reset") {
+    state.run([&] {
+        Vcontrol_unit control_unit{};
+        control_unit.eval();
+        bench::do_not_optimize(control_unit.signals);
+    });
+}
+
+BENCHMARK("ram/eval") {
+    Vram ram{};
+    ram.chip_enable = 0;
+    ram.chip_enable2 = 1;
+    ram.output_enable = 0;
+    ram.write_enable = 1;
+    ram.data_in_en = 0;
+    auto address = uint16_t{0};
+    state.run([&] {
+        ram.address = address++;
+        ram.eval();
+        bench::do_not_optimize(ram.data_out);
+    });
+}
+
+BENCHMARK("ram/write") {
+    Vram ram{};
+    ram.chip_enable = 0;
+    ram.chip_enable2 = 1;
+    ram.output_enable = 1;
+    ram.data_in_en = 1;
+    auto address = uint16_t{0};
+    state.run([&] {
+        ram.address = address;
+        ram.data_in = static_cast<uint8_t>(address++);
+        ram.write_enable = 0;
+        ram.eval();
+        ram.write_enable = 1;
+        ram.eval();
+    });
+}
+
+BENCHMARK("ram/reset") {
+    state.run([&] {
+        Vram ram{};
+        ram.eval();
+        bench::do_not_optimize(ram.data_out);
+    });
+}
+
+BENCHMARK("mem_unit/eval") {
+    Vmem_unit mem{};
+    reset(mem);
+    mem.eval();
+    auto address = uint16_t{0};
+    state.run([&] {
+        load_mar_mbr(mem, address++, 0x00);
+        mem.eval();
+        bench::do_not_optimize(mem.data_out);
+    });
+}
+
+BENCHMARK("mem_unit/clocked") {
+    Vmem_unit mem{};
+    reset(mem);
+    mem.eval();
+    auto address = uint16_t{0};
+    state.run([&] {
+        // a complete write: load MAR and MBR, then store MBR
+        load_mar_mbr(mem, address, static_cast<uint8_t>(address));
+        address++;
+        mem.eval();
+        load_mbr_to_mem(mem);
+        mem.eval();
+    });
+}
+
+BENCHMARK("mem_unit/reset") {
+    state.run([&] {
+        Vmem_unit mem{};
+        reset(mem);
+        mem.eval();
+        bench::do_not_optimize(mem.data_out);
+    });
+}
+
+BENCHMARK("tmp/eval") {
+    Vtmp tmp{};
+    tmp.reg_tmph_pass_data = 1;
+    tmp.reg_tmpl_pass_data = 1;
+    tmp.reg_tmph_out = 1;
+    tmp.reg_tmpl_out = 1;
+    tmp.reg_tmp_pass_address = 1;
+    tmp.data_in_en = 1;
+    auto value = uint8_t{0};
+    state.run([&] {
+        tmp.data_in = value++;
+        tmp.reg_tmpl_load = value & 1;
+        tmp.eval();
+        bench::do_not_optimize(tmp.data_out);
+    });
+}
+
+BENCHMARK("tmp/reset") {
+    state.run([&] {
+        Vtmp tmp{};
+        tmp.eval();
+        bench::do_not_optimize(tmp.data_out);
+    });
+}
+
+// The whole CPU running a loop of nops - this measures the cost of the fetch/decode machinery
+template <typename Cpu> void cpu_clocked(bench::State &state) {
+    constexpr uint8_t nop = 0xEF;
+    constexpr uint8_t jmp_imm = 0xB2;
+    const uint8_t program[] = {nop, nop, nop, nop, nop, nop, nop, nop, jmp_imm, 0x00, 0x00};
+
+    System<Cpu> system{};
+    system.store(0x0000, program);
+    state.run([&] {
+        system.half_cycle();
+        system.half_cycle();
+    });
+    bench::do_not_optimize(system.pc());
+}
+
+template <typename Cpu> void cpu_reset(bench::State &state) {
+    state.run([&] {
+        System<Cpu> system{};
+        bench::do_not_optimize(system.pc());
+    });
+}
+
+BENCHMARK("cpu/clocked") { cpu_clocked<Vcpu>(state); }
+BENCHMARK("cpu/reset") { cpu_reset<Vcpu>(state); }
+BENCHMARK("cpu_mux/clocked") { cpu_clocked<Vcpu_mux>(state); }
+BENCHMARK("cpu_mux/reset") { cpu_reset<Vcpu_mux>(state); }
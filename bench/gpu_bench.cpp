@@ -0,0 +1,166 @@
+#include "Vgpu.h"
+#include "Vmodcounter.h"
+#include "Vmonitor_tester.h"
+#include "bench.hpp"
+#include "gpu_command_port.hpp"
+
+BENCHMARK("gpu/eval") {
+    Vgpu gpu{};
+    gpu.rst = 0;
+    gpu.eval();
+    state.run([&] {
+        gpu.eval();
+        bench::do_not_optimize(gpu.red);
+    });
+}
+
+BENCHMARK("gpu/clocked") {
+    Vgpu gpu{};
+    gpu.rst = 0;
+    state.run([&] {
+        gpu.clk = 1;
+        gpu.eval();
+        gpu.clk = 0;
+        gpu.eval();
+        bench::do_not_optimize(gpu.red);
+    });
+}
+
+BENCHMARK("gpu/reset") {
+    state.run([&] {
+        Vgpu gpu{};
+        gpu.rst = 0;
+        gpu.eval();
+        bench::do_not_optimize(gpu.red);
+    });
+}
+
+// Same sequence as typing a character in the simulator, followed by a clock so the write completes
+BENCHMARK("gpu/store_byte") {
+    Vgpu gpu{};
+    gpu.rst = 0;
+    auto c = uint8_t{'a'};
+    state.run([&] {
+        gpu.interrupt_enable = 1;
+        gpu.interrupt_code_in = 0b00;
+        gpu.interrupt_data_in = c;
+        gpu.eval();
+        gpu.interrupt_enable = 0;
+        gpu.eval();
+        gpu.clk = 1;
+        gpu.eval();
+        gpu.clk = 0;
+        gpu.eval();
+        c = c == 'z' ? 'a' : static_cast<uint8_t>(c + 1);
+    });
+}
+
+namespace {
+    void run_until_idle(Vgpu &gpu, GpuCommandPort<Vgpu> &port) {
+        while (!port.empty() || gpu.busy) {
+            gpu.clk = 1;
+            port.eval();
+            gpu.clk = 0;
+            port.eval();
+        }
+    }
+
+    constexpr auto scroll_lines = 1000u;
+}
+
+// One 80 character row through the command port, clocked until the last write completed
+BENCHMARK("gpu/command_port_row") {
+    Vgpu gpu{};
+    gpu.rst = 0;
+    auto port = GpuCommandPort{&gpu};
+    state.run([&] {
+        for (auto i = 0u; i < 80u; i++) {
+            port.store_byte(static_cast<uint8_t>('a' + i % 26u));
+        }
+        run_until_idle(gpu, port);
+    });
+}
+
+// SIG_CLEAR, clocked until the GPU is idle again
+BENCHMARK("gpu/clear") {
+    Vgpu gpu{};
+    gpu.rst = 0;
+    auto port = GpuCommandPort{&gpu};
+    state.run([&] {
+        port.clear();
+        run_until_idle(gpu, port);
+    });
+}
+
+// A terminal scrolling 1000 lines by rewriting the whole screen for every line
+BENCHMARK("gpu/scroll_1000_lines/rewrite") {
+    Vgpu gpu{};
+    gpu.rst = 0;
+    auto port = GpuCommandPort{&gpu};
+    state.run([&] {
+        for (auto line = 0u; line < scroll_lines; line++) {
+            for (auto i = 0u; i < 80u * 60u; i++) {
+                port.store_byte(static_cast<uint8_t>('a' + (line + i / 80u) % 26u));
+            }
+            run_until_idle(gpu, port);
+        }
+    });
+}
+
+// The same with the scroll register, one command and the new bottom row per line
+BENCHMARK("gpu/scroll_1000_lines/register") {
+    Vgpu gpu{};
+    gpu.rst = 0;
+    auto port = GpuCommandPort{&gpu};
+    auto row = 0u;
+    state.run([&] {
+        for (auto line = 0u; line < scroll_lines; line++) {
+            row = (row + 1u) % 60u;
+            port.scroll_to(static_cast<uint8_t>(row));
+            // the cursor is past the bottom row again, back to its start
+            port.move_cursor_rows(-1);
+            for (auto i = 0u; i < 80u; i++) {
+                port.store_byte(static_cast<uint8_t>('a' + (line + 59u) % 26u));
+            }
+            run_until_idle(gpu, port);
+        }
+    });
+}
+
+BENCHMARK("modcounter/clocked") {
+    Vmodcounter counter{};
+    state.run([&] {
+        counter.clk = 1;
+        counter.eval();
+        counter.clk = 0;
+        counter.eval();
+        bench::do_not_optimize(counter.data_out);
+    });
+}
+
+BENCHMARK("modcounter/reset") {
+    state.run([&] {
+        Vmodcounter counter{};
+        counter.eval();
+        bench::do_not_optimize(counter.data_out);
+    });
+}
+
+BENCHMARK("monitor_tester/clocked") {
+    Vmonitor_tester monitor_tester{};
+    state.run([&] {
+        monitor_tester.clk = 1;
+        monitor_tester.eval();
+        monitor_tester.clk = 0;
+        monitor_tester.eval();
+        bench::do_not_optimize(monitor_tester.red);
+    });
+}
+
+BENCHMARK("monitor_tester/reset") {
+    state.run([&] {
+        Vmonitor_tester monitor_tester{};
+        monitor_tester.eval();
+        bench::do_not_optimize(monitor_tester.red);
+    });
+}
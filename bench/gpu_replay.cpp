@@ -0,0 +1,175 @@
+#include "Vgpu.h"
+#include "clockable_module.hpp"
+#include "frame_hash.hpp"
+#include "gpu_stream.hpp"
+#include "video_capture.hpp"
+#include "vga_simulator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fmt/base.h>
+#include <fmt/format.h>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// gpu_replay STREAM [--frames N] [--hashes FILE] [--expect FILE] [--video FILE]
+//
+// Replays a command stream recorded with `SIM_GPU_RECORD=FILE simulator` into Vgpu without the CPU or a window,
+// with the same GPU clock as in the simulator. Every frame is hashed, --hashes writes one hash per line and
+// --expect compares against such a file (exit code 1 on a difference). --frames renders N >= 1 frames, without it
+// the replay renders until the last command was sent plus one frame. --video records the frames, see simulator/video_capture. Reports the rendered
+// frames/s.
+
+struct Options {
+    std::string stream;
+    std::optional<uint64_t> frames{};
+    std::optional<std::string> hashes{};
+    std::optional<std::string> expect{};
+    std::optional<std::string> video{};
+};
+
+auto parse_options(int argc, char **argv) -> std::optional<Options> {
+    if (argc < 2) {
+        fmt::println(stderr, "usage: {} STREAM [--frames N] [--hashes FILE] [--expect FILE] [--video FILE]", argv[0]);
+        return std::nullopt;
+    }
+
+    auto options = Options{.stream = argv[1]};
+    for (auto i = 2; i < argc; i++) {
+        const auto arg = std::string_view{argv[i]};
+        const auto has_value = i + 1 < argc;
+
+        if (arg == "--frames" && has_value) {
+            options.frames = std::strtoull(argv[++i], nullptr, 10);
+            // also what an unparsable count reads as, there would be no last frame to report
+            if (*options.frames == 0u) {
+                fmt::println(stderr, "--frames needs a positive number of frames, got {}", argv[i]);
+                return std::nullopt;
+            }
+        } else if (arg == "--hashes" && has_value) {
+            options.hashes = argv[++i];
+        } else if (arg == "--expect" && has_value) {
+            options.expect = argv[++i];
+        } else if (arg == "--video" && has_value) {
+            options.video = argv[++i];
+        } else {
+            fmt::println(stderr, "unknown or incomplete argument: {}", arg);
+            return std::nullopt;
+        }
+    }
+
+    return options;
+}
+
+auto read_hashes(const std::string &path) -> std::vector<uint64_t> {
+    auto hashes = std::vector<uint64_t>{};
+    auto file = std::ifstream{path};
+    for (auto line = std::string{}; std::getline(file, line);) {
+        if (!line.empty()) {
+            hashes.push_back(std::stoull(line, nullptr, 16));
+        }
+    }
+    return hashes;
+}
+
+auto main(int argc, char **argv) -> int {
+    const auto options = parse_options(argc, argv);
+    if (!options) {
+        return 2;
+    }
+
+    const auto commands = gpu_stream::read(options->stream);
+    if (!commands) {
+        fmt::println(stderr, "{} is not a GPU command stream", options->stream);
+        return 2;
+    }
+
+    auto gpu = Vgpu{};
+    gpu.rst = 0;
+
+    auto gpu_clock = Clock{&gpu, 1, 0, true};
+    auto replay_clock = gpu_stream::ReplayClock{&gpu, std::span{*commands}};
+    auto scheduler = ClockScheduler{};
+    scheduler.add_clock(&gpu_clock);
+    scheduler.add_clock(&replay_clock);
+
+    auto simulator = VGASimulator{&gpu, &scheduler};
+    if (const auto synced = simulator.sync(); !synced) {
+        std::visit([](const auto &error) { fmt::println(stderr, "sync failed: {}", error.message()); },
+                   synced.error());
+        return 1;
+    }
+
+    auto video = std::optional<video_capture::Writer>{};
+    if (options->video) {
+        video.emplace(*options->video, static_cast<uint16_t>(h_visible_area), static_cast<uint16_t>(v_visible_area));
+        if (!video->is_open()) {
+            fmt::println(stderr, "failed to open {}", *options->video);
+            return 2;
+        }
+    }
+
+    auto hashes = std::vector<uint64_t>{};
+    const auto start = std::chrono::steady_clock::now();
+    for (auto trailing = 0u; options->frames ? hashes.size() < *options->frames : trailing < 1u;) {
+        trailing += replay_clock.done() ? 1u : 0u;
+
+        auto hash = FrameHash{};
+        auto *video_frame = video ? video->begin_frame() : nullptr;
+        const auto frame =
+            simulator.process_vga_frame([&hash, video_frame](const uint32_t x, const uint32_t y, const Color color) {
+                hash.add(color);
+                if (video_frame) {
+                    video_frame[y * h_visible_area + x] = video_capture::pack(color.r, color.g, color.b);
+                }
+            });
+        if (video) {
+            video->end_frame();
+        }
+        if (!frame) {
+            std::visit([&](const auto &error) { fmt::println(stderr, "frame {}: {}", hashes.size(), error.message()); },
+                       frame.error());
+            return 1;
+        }
+        hashes.push_back(hash.value);
+    }
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    fmt::println("{} commands, {} frames in {:.3f} s, {:.2f} frames/s, last frame {:016x}", commands->size(),
+                 hashes.size(), seconds, static_cast<double>(hashes.size()) / seconds, hashes.back());
+
+    if (options->hashes) {
+        auto *file = std::fopen(options->hashes->c_str(), "w");
+        if (file == nullptr) {
+            fmt::println(stderr, "failed to open {}", *options->hashes);
+            return 2;
+        }
+        for (const auto hash : hashes) {
+            fmt::println(file, "{:016x}", hash);
+        }
+        std::fclose(file);
+    }
+
+    if (!options->expect) {
+        return 0;
+    }
+
+    const auto expected = read_hashes(*options->expect);
+    auto differences = 0u;
+    for (auto i = 0u; i < std::max(expected.size(), hashes.size()); i++) {
+        if (i >= expected.size() || i >= hashes.size() || expected[i] != hashes[i]) {
+            if (differences++ == 0u) {
+                fmt::println("frame {} differs from {}", i, *options->expect);
+            }
+        }
+    }
+    if (differences > 0u) {
+        fmt::println("{} frames differ", differences);
+    }
+    return differences == 0u ? 0 : 1;
+}
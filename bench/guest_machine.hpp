@@ -0,0 +1,221 @@
+#pragma once
+
+#include "Vcpu.h"
+#include "Vcpu___024root.h"
+#include "Vgpu.h"
+#include "bus_trace.hpp"
+#include "cpu_system.hpp"
+#include "gpu_command_port.hpp"
+#include "mmio.hpp"
+#include "ps2_line.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// The CPU with its memory and the devices the workloads use, clockable by a ClockScheduler.
+// The devices are registers in the I/O window at 0xFF00-0xFF0F, below the interrupt vectors. Keep the addresses in
+// sync with tools/make_workloads.py:
+//  gpu_port        - (write) every non-zero byte is sent to the GPU as a character
+//  keyboard_port   - (read) the last byte the PS/2 keyboard controller received, reading it clears keyboard_status
+//  keyboard_status - (read) bit 0 is set while a received byte hasn't been read
+//  gpu_cursor      - (write) SIG_MOVE_CURSOR, see GpuCommandPort::move_cursor_columns
+//  gpu_display     - (write) SIG_DISPLAY, scroll, double buffering and page flips
+//  gpu_clear       - (write) clears the screen with the written character
+//  gpu_status      - (read) bit 0 is set while GPU commands are queued or the GPU is still writing one
+//  cycle_counter   - (read) `cycles` in 8 bytes, little endian, reading the lowest byte latches the other seven
+// Everything else in the window, and every write, goes to memory as well.
+//
+// Keys go through the PS/2 lines like in the simulator, `keyboard.send_key` queues the scan codes of a key event and
+// `keyboard_lines` has to be added to the scheduler next to the CPU's clock.
+struct GuestMachine {
+    static constexpr uint16_t io_base = 0xFF00;
+    static constexpr std::size_t io_size = 16u;
+    static constexpr uint16_t gpu_port = 0xFF00;
+    static constexpr uint16_t keyboard_port = 0xFF01;
+    static constexpr uint16_t keyboard_status = 0xFF02;
+    static constexpr uint16_t gpu_cursor = 0xFF03;
+    static constexpr uint16_t gpu_display = 0xFF04;
+    static constexpr uint16_t gpu_clear = 0xFF05;
+    static constexpr uint16_t gpu_status = 0xFF06;
+    static constexpr uint16_t cycle_counter = 0xFF08;
+    // the GPU's clock, a period of 1 in the scheduler
+    static constexpr uint64_t pixel_clock_hz = 25'175'000u;
+
+    System<Vcpu> system{};
+    GpuCommandPort<Vgpu> *gpu = nullptr;
+
+    ps2::Keyboard keyboard{};
+    ps2::Receiver keyboard_controller{};
+    ps2::LineDriver<ps2::Receiver> keyboard_lines{&keyboard, &keyboard_controller,
+                                                  ps2::clock_half_period(pixel_clock_hz)};
+    std::vector<uint8_t> gpu_text{};
+    // rising CPU clock edges since reset
+    uint64_t cycles = 0u;
+    // every MAR/MBR load, read and write goes here when set
+    bus_trace::Writer *trace_writer = nullptr;
+
+    auto clk() -> CData * { return &system.cpu.clk; }
+
+    // Stores `bytes` before the run, they go into the bus trace as well so a replay starts from the same memory
+    void load(uint16_t address, std::span<const uint8_t> bytes) {
+        system.store(address, bytes);
+        if (trace_writer != nullptr) {
+            for (const auto &transaction : bus_trace::preload(address, bytes, cycles)) {
+                trace_writer->record(transaction);
+            }
+        }
+    }
+
+    void eval() {
+        auto &cpu = system.cpu;
+        auto &mem = system.mem;
+        const bool clk = cpu.clk;
+
+        cpu.eval();
+        mem.zero_page = cpu.zero_page;
+        mem.mem_part = cpu.mem_part;
+        mem.mem_in = cpu.mem_in;
+        mem.mem_out = cpu.mem_out;
+        mem.reg_mbr_load = cpu.reg_mbr_load & clk;
+        mem.reg_mbr_word_dir = cpu.reg_mbr_word_dir;
+        mem.reg_mar_load = cpu.reg_mar_load & clk;
+        mem.data_in_en = cpu.reg_mbr_load;
+        mem.data_in = cpu.bus_out;
+        mem.address = cpu.addr_bus;
+        mem.eval();
+
+        // mem_unit keeps MAR and MBR to itself, so they are latched here on the same edges
+        if (mem.reg_mar_load && !last_mar_load) {
+            mar = cpu.addr_bus;
+            record(bus_trace::Kind::MarLoad, 0u);
+        }
+        if (mem.reg_mbr_load && !last_mbr_load) {
+            mbr = cpu.bus_out;
+            record(bus_trace::Kind::MbrLoad, mbr);
+        }
+
+        const bool writing = !cpu.mem_in;
+        if (writing && !last_writing) {
+            record(bus_trace::Kind::Write, mbr);
+            if (const auto *reg = find_register(); reg != nullptr && reg->write != nullptr) {
+                reg->write(*this, mbr);
+            }
+        }
+
+        // a register is read once when the read starts, its value stays on the bus until the read ends
+        const bool reading = !cpu.mem_out;
+        if (reading && !last_reading) {
+            const auto *reg = find_register();
+            io_read = reg != nullptr && reg->read != nullptr;
+            io_data = io_read ? reg->read(*this) : 0u;
+        }
+
+        cpu.bus_in_en = (~mem.mem_out & 1);
+        cpu.bus_in = reading && io_read ? io_data : mem.data_out;
+        cpu.eval();
+
+        if (reading && !last_reading) {
+            record(bus_trace::Kind::Read, cpu.bus_in);
+        }
+
+        cycles += clk && !last_clk ? 1u : 0u;
+        last_clk = clk;
+        last_mar_load = mem.reg_mar_load;
+        last_mbr_load = mem.reg_mbr_load;
+        last_writing = writing;
+        last_reading = reading;
+    }
+
+    auto pc() const { return system.pc(); }
+
+  private:
+    using IoDecoder = mmio::Decoder<GuestMachine, io_size>;
+
+    static auto io_map() -> IoDecoder {
+        auto decoder = IoDecoder{io_base};
+        decoder.map(gpu_port, {.write = [](GuestMachine &machine, uint8_t value) {
+                                   if (value != 0u) {
+                                       machine.send_char(value);
+                                   }
+                               }});
+        decoder.map(keyboard_port,
+                    {.read = [](GuestMachine &machine) -> uint8_t { return machine.keyboard_controller.read(); }});
+        decoder.map(keyboard_status, {.read = [](GuestMachine &machine) -> uint8_t {
+                                          return machine.keyboard_controller.interrupt;
+                                      }});
+        decoder.map(gpu_cursor, {.write = [](GuestMachine &machine, uint8_t value) {
+                                     machine.send_command(gpu_stream::Code::MoveCursor, value);
+                                 }});
+        decoder.map(gpu_display, {.write = [](GuestMachine &machine, uint8_t value) {
+                                      machine.send_command(gpu_stream::Code::Display, value);
+                                  }});
+        decoder.map(gpu_clear, {.write = [](GuestMachine &machine, uint8_t value) {
+                                    machine.send_command(gpu_stream::Code::Clear, value);
+                                }});
+        decoder.map(gpu_status, {.read = [](GuestMachine &machine) -> uint8_t {
+                                     return machine.gpu != nullptr && machine.gpu->busy();
+                                 }});
+        decoder.map(cycle_counter, {.read = [](GuestMachine &machine) -> uint8_t {
+                                        machine.latched_cycles = machine.cycles;
+                                        return static_cast<uint8_t>(machine.latched_cycles);
+                                    }});
+        for (auto i = 1u; i < 8u; i++) {
+            decoder.map(static_cast<uint16_t>(cycle_counter + i), {.read = [](GuestMachine &machine) -> uint8_t {
+                                                                       return machine.latched_cycle_byte();
+                                                                   }});
+        }
+        return decoder;
+    }
+
+    const IoDecoder io = io_map();
+
+    uint16_t mar = 0u;
+    uint8_t mbr = 0u;
+    bool io_read = false;
+    uint8_t io_data = 0u;
+    uint64_t latched_cycles = 0u;
+
+    bool last_clk = true;
+    bool last_mar_load = false;
+    bool last_mbr_load = false;
+    bool last_writing = false;
+    bool last_reading = false;
+
+    void record(bus_trace::Kind kind, uint8_t data) {
+        if (trace_writer == nullptr) {
+            return;
+        }
+
+        const auto &cpu = system.cpu;
+        trace_writer->record({.cycle = cycles,
+                              .address = mar,
+                              .data = data,
+                              .kind = kind,
+                              .zero_page = cpu.zero_page != 0,
+                              .mem_part = cpu.mem_part != 0});
+    }
+
+    // The register of the access that starts now, stack and zero page accesses go to memory
+    auto find_register() const -> const IoDecoder::Register * {
+        const auto &cpu = system.cpu;
+        return io.find(mar, cpu.mem_part != 0, cpu.zero_page != 0);
+    }
+
+    // The byte of `latched_cycles` at the register being read
+    auto latched_cycle_byte() const -> uint8_t {
+        return static_cast<uint8_t>(latched_cycles >> (8u * static_cast<uint16_t>(mar - cycle_counter)));
+    }
+
+    void send_command(gpu_stream::Code code, uint8_t data) {
+        if (gpu != nullptr) {
+            gpu->push(code, data);
+        }
+    }
+
+    void send_char(uint8_t c) {
+        gpu_text.push_back(c);
+        if (gpu != nullptr) {
+            gpu->store_byte(c);
+        }
+    }
+};
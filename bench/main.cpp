@@ -0,0 +1,146 @@
+#include "bench.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fmt/base.h>
+#include <fmt/format.h>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// sim_bench [--filter SUBSTRING] [--min-time SECONDS] [--output FILE] [--baseline FILE] [--threshold FRACTION]
+//
+// --output writes the results as JSON, a file written this way can later be passed as --baseline.
+// With a baseline every benchmark slower than baseline * (1 + threshold) is reported and the exit code is 1, as it is
+// when a benchmark fails.
+
+struct Options {
+    std::string filter{};
+    double min_time = 0.2;
+    std::optional<std::string> output{};
+    std::optional<std::string> baseline{};
+    double threshold = 0.10;
+};
+
+struct Result {
+    std::string name;
+    uint64_t iterations;
+    double ns_per_op;
+    std::optional<std::string> failure{};
+};
+
+auto parse_options(int argc, char **argv) -> std::optional<Options> {
+    auto options = Options{};
+
+    for (auto i = 1; i < argc; i++) {
+        const auto arg = std::string_view{argv[i]};
+        const auto has_value = i + 1 < argc;
+
+        if (arg == "--filter" && has_value) {
+            options.filter = argv[++i];
+        } else if (arg == "--min-time" && has_value) {
+            options.min_time = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--output" && has_value) {
+            options.output = argv[++i];
+        } else if (arg == "--baseline" && has_value) {
+            options.baseline = argv[++i];
+        } else if (arg == "--threshold" && has_value) {
+            options.threshold = std::strtod(argv[++i], nullptr);
+        } else {
+            fmt::println(stderr, "unknown or incomplete argument: {}", arg);
+            return std::nullopt;
+        }
+    }
+
+    return options;
+}
+
+auto run_benchmark(const bench::Benchmark &benchmark, double min_time) -> Result {
+    const auto min_time_ns = min_time * 1e9;
+    auto state = bench::State{};
+
+    while (true) {
+        benchmark.function(state);
+        if (state.failure) {
+            return {benchmark.name, 0u, 0.0, state.failure};
+        }
+        if (state.elapsed_ns >= min_time_ns) {
+            break;
+        }
+
+        // aim slightly above the minimum so most benchmarks need only one more round
+        const auto scale = state.elapsed_ns > 0.0 ? min_time_ns / state.elapsed_ns * 1.2 : 100.0;
+        state.iterations = static_cast<uint64_t>(static_cast<double>(state.iterations) * std::clamp(scale, 2.0, 100.0));
+    }
+
+    return {benchmark.name, state.iterations, state.elapsed_ns / static_cast<double>(state.iterations)};
+}
+
+void write_results(const std::string &path, const std::vector<Result> &results) {
+    auto *file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        fmt::println(stderr, "failed to open {}", path);
+        return;
+    }
+
+    // one benchmark per line, `bench::read_baseline` depends on it
+    fmt::print(file, "{{\n  \"benchmarks\": [\n");
+    for (auto i = 0u; i < results.size(); i++) {
+        const auto &result = results[i];
+        fmt::print(file, "    {{\"name\": \"{}\", \"iterations\": {}, \"ns_per_op\": {:.3f}}}{}\n", result.name,
+                   result.iterations, result.ns_per_op, i + 1 < results.size() ? "," : "");
+    }
+    fmt::print(file, "  ]\n}}\n");
+    std::fclose(file);
+}
+
+auto main(int argc, char **argv) -> int {
+    const auto options = parse_options(argc, argv);
+    if (!options) {
+        return 2;
+    }
+
+    auto results = std::vector<Result>{};
+    auto failures = 0u;
+    for (const auto &benchmark : bench::registry()) {
+        if (benchmark.name.find(options->filter) == std::string::npos) {
+            continue;
+        }
+
+        const auto result = run_benchmark(benchmark, options->min_time);
+        if (result.failure) {
+            failures++;
+            fmt::println("{:<40} FAILED: {}", result.name, *result.failure);
+            continue;
+        }
+        fmt::println("{:<40} {:>14.1f} ns/op {:>12} iterations", result.name, result.ns_per_op, result.iterations);
+        results.push_back(result);
+    }
+
+    if (options->output) {
+        write_results(*options->output, results);
+    }
+
+    if (!options->baseline) {
+        return failures == 0u ? 0 : 1;
+    }
+
+    const auto baseline = bench::read_baseline(*options->baseline, "ns_per_op");
+    auto regressions = 0u;
+
+    fmt::println("\ncompared to {} (threshold {:.0f}%):", *options->baseline, options->threshold * 100.0);
+    for (const auto &result : results) {
+        const auto it = baseline.find(result.name);
+        if (it == baseline.end() || it->second <= 0.0) {
+            fmt::println("{:<40} no baseline", result.name);
+            continue;
+        }
+
+        const auto change = result.ns_per_op / it->second - 1.0;
+        const auto regressed = change > options->threshold;
+        regressions += regressed ? 1u : 0u;
+        fmt::println("{:<40} {:>+8.1f}%{}", result.name, change * 100.0, regressed ? "  REGRESSION" : "");
+    }
+
+    return failures == 0u && regressions == 0u ? 0 : 1;
+}
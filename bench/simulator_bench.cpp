@@ -0,0 +1,183 @@
+#include "Vgpu.h"
+#include "Vmonitor_tester.h"
+#include "bench.hpp"
+#include "clockable_module.hpp"
+#include "ps2_line.hpp"
+#include "vga_simulator.hpp"
+#include <array>
+
+namespace {
+    // Costs nothing to eval, isolates the scheduler's own overhead
+    struct NullModule {
+        uint8_t clk = 0;
+        void eval() {}
+    };
+
+    // gpu.sv's timing generator for any profile, with its quirks (one more display line, the vertical state moves
+    // when the line enters the sync), so the capture loop can be measured for modes the GPU doesn't have
+    template <VGATiming Timing> struct TimingDriver {
+        uint8_t clk = 0;
+        uint8_t red = 0;
+        uint8_t green = 0;
+        uint8_t blue = 0;
+        uint8_t hsync = 0;
+        uint8_t vsync = 0;
+        VGAPosition position{VGAPosition::Display, 0u, VGAPosition::Display, 0u};
+
+        void eval() {
+            if (clk != 0u && last_clk == 0u) {
+                step();
+            }
+            last_clk = clk;
+
+            hsync = (position.h_region == VGAPosition::Sync) == Timing.hsync_active_high;
+            vsync = (position.v_region == VGAPosition::Sync) == Timing.vsync_active_high;
+            const auto visible = position.h_region == VGAPosition::Display && position.v_region == VGAPosition::Display;
+            red = visible ? static_cast<uint8_t>(position.h_counter & 0xfu) : 0u;
+            green = visible ? static_cast<uint8_t>(position.v_counter & 0xfu) : 0u;
+        }
+
+      private:
+        constexpr static auto h_length = std::array<uint32_t, 4>{
+            Timing.h_front_porch, Timing.h_sync_pulse_width, Timing.h_back_porch, Timing.h_visible_area};
+        constexpr static auto v_length = std::array<uint32_t, 4>{
+            Timing.v_front_porch, Timing.v_sync_pulse_width, Timing.v_back_porch, Timing.v_visible_area + 1u};
+
+        // regions follow each other in the order of the enum, wrapping from Display to FrontPorch
+        static void advance(uint8_t &region, uint32_t &counter, const std::array<uint32_t, 4> &length) {
+            if (++counter == length[region]) {
+                counter = 0u;
+                region = static_cast<uint8_t>((region + 1u) % 4u);
+            }
+        }
+
+        void step() {
+            advance(position.h_region, position.h_counter, h_length);
+            if (position.h_region == VGAPosition::Sync && position.h_counter == 0u) {
+                advance(position.v_region, position.v_counter, v_length);
+            }
+        }
+
+        uint8_t last_clk = 0;
+    };
+
+    template <VGATiming Timing> auto vga_position(const TimingDriver<Timing> &driver) -> VGAPosition {
+        return driver.position;
+    }
+}
+
+BENCHMARK("clock_scheduler/advance_2_clocks") {
+    NullModule fast{};
+    NullModule slow{};
+    auto fast_clock = Clock{&fast, 1, 0, true};
+    auto slow_clock = Clock{&slow, 4, 0, true};
+
+    auto scheduler = ClockScheduler{};
+    scheduler.add_clock(&fast_clock);
+    scheduler.add_clock(&slow_clock);
+
+    state.run([&] { scheduler.advance(); });
+}
+
+// An idle PS/2 line driver left in the scheduler, what LineDriver::schedule saves compared to advance_2_clocks
+BENCHMARK("clock_scheduler/advance_2_clocks_idle_ps2") {
+    NullModule fast{};
+    NullModule slow{};
+    auto fast_clock = Clock{&fast, 1, 0, true};
+    auto slow_clock = Clock{&slow, 4, 0, true};
+    auto keyboard = ps2::Keyboard{};
+    auto receiver = ps2::Receiver{};
+    auto driver = ps2::LineDriver{&keyboard, &receiver, ps2::clock_half_period(25'175'000u)};
+
+    auto scheduler = ClockScheduler{};
+    scheduler.add_clock(&fast_clock);
+    scheduler.add_clock(&slow_clock);
+    scheduler.add_clock(&driver);
+
+    state.run([&] { scheduler.advance(); });
+}
+
+BENCHMARK("clock_scheduler/advance_8_clocks") {
+    auto modules = std::array<NullModule, 8>{};
+    auto clocks = std::vector<Clock<NullModule>>{};
+    clocks.reserve(modules.size());
+    for (auto i = 0u; i < modules.size(); i++) {
+        clocks.emplace_back(&modules[i], i + 1u, i + 1u, true);
+    }
+
+    auto scheduler = ClockScheduler{};
+    for (auto &clock : clocks) {
+        scheduler.add_clock(&clock);
+    }
+
+    state.run([&] { scheduler.advance(); });
+}
+
+// One whole frame captured into a pixel buffer, the way the simulator's main loop does it
+template <typename Driver, VGATiming Timing = vga_timing::vga_640x480>
+void capture_frame(bench::State &state, SyncValidation validation = {}) {
+    Driver driver{};
+    auto clock = Clock{&driver, 1, 0, true};
+    auto scheduler = ClockScheduler{};
+    scheduler.add_clock(&clock);
+
+    auto simulator = VGASimulator<Driver, Timing>{&driver, &scheduler};
+    simulator.sync_checker.validation = validation;
+    if (!simulator.sync()) {
+        state.fail("no vsync to sync to");
+        return;
+    }
+
+    auto pixels = std::vector<uint32_t>(Timing.h_visible_area * Timing.v_visible_area);
+    state.run([&] {
+        simulator.process_vga_frame([&](const uint32_t x, const uint32_t y, const Color color) {
+            pixels[y * Timing.h_visible_area + x] = static_cast<uint32_t>(color.r) << 16u |
+                                                    static_cast<uint32_t>(color.g) << 8u | color.b;
+        });
+    });
+    bench::do_not_optimize(pixels.front());
+}
+
+BENCHMARK("vga_simulator/sync_gpu") {
+    state.run([&] {
+        Vgpu gpu{};
+        gpu.rst = 0;
+        auto clock = Clock{&gpu, 1, 0, true};
+        auto scheduler = ClockScheduler{};
+        scheduler.add_clock(&clock);
+
+        VGASimulator simulator{&gpu, &scheduler};
+        bench::do_not_optimize(simulator.sync().has_value());
+    });
+}
+
+// The pulse scanning path sync() used before it read the GPU's timing state
+BENCHMARK("vga_simulator/sync_gpu_edges") {
+    state.run([&] {
+        Vgpu gpu{};
+        gpu.rst = 0;
+        auto clock = Clock{&gpu, 1, 0, true};
+        auto scheduler = ClockScheduler{};
+        scheduler.add_clock(&clock);
+
+        VGASimulator simulator{&gpu, &scheduler};
+        bench::do_not_optimize(simulator.sync_by_edges().has_value());
+    });
+}
+
+BENCHMARK("vga_simulator/frame_gpu") { capture_frame<Vgpu>(state); }
+BENCHMARK("vga_simulator/frame_monitor_tester") { capture_frame<Vmonitor_tester>(state); }
+// Only the first frame's sync timing is checked, the others skip the checker
+BENCHMARK("vga_simulator/frame_gpu_unchecked") {
+    capture_frame<Vgpu>(state, {.level = SyncValidation::Level::FirstFrame});
+}
+
+BENCHMARK("vga_simulator/frame_640x480") {
+    capture_frame<TimingDriver<vga_timing::vga_640x480>, vga_timing::vga_640x480>(state);
+}
+BENCHMARK("vga_simulator/frame_800x600") {
+    capture_frame<TimingDriver<vga_timing::svga_800x600>, vga_timing::svga_800x600>(state);
+}
+BENCHMARK("vga_simulator/frame_1024x768") {
+    capture_frame<TimingDriver<vga_timing::xga_1024x768>, vga_timing::xga_1024x768>(state);
+}
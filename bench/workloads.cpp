@@ -0,0 +1,365 @@
+#include "Vgpu.h"
+#include "bench.hpp"
+#include "clockable_module.hpp"
+#include "guest_machine.hpp"
+#include "vga_simulator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fmt/base.h>
+#include <fmt/format.h>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// sim_workloads [--workloads DIR] [--filter SUBSTRING] [--min-time SECONDS] [--output FILE] [--baseline FILE]
+//               [--threshold FRACTION] [--check-only] [--bus-trace DIR]
+//
+// Runs the guest programs in resources/workloads (generated by tools/make_workloads.py) on the CPU with the GPU
+// clocked next to it, like in the simulator. Every workload is first checked against its expected results and
+// cycle count, then rerun until it took at least `--min-time` to measure the host throughput.
+//
+// --output writes the throughput as JSON, a file written this way can later be passed as --baseline. Without
+// --baseline, `baseline.json` in the workload directory is used. Every workload whose cycles/s dropped below
+// baseline * (1 - threshold) or that has no baseline is reported and the exit code is 1, as it is for failed checks.
+// Measuring without any baseline file fails unless --output records one, `just workloads-baseline` records
+// resources/workloads/baseline.json.
+//
+// --bus-trace records the memory transactions of every checked run to `DIR/<workload>.bustrace`, those can be
+// replayed against the memory unit alone with bus_replay.
+
+struct Options {
+    std::string workloads = WORKLOADS_DIR;
+    std::string filter{};
+    double min_time = 0.5;
+    std::optional<std::string> output{};
+    std::optional<std::string> baseline{};
+    double threshold = 0.10;
+    bool check_only = false;
+    std::optional<std::string> bus_trace{};
+};
+
+struct Workload {
+    std::string name;
+    std::vector<std::pair<uint16_t, std::vector<uint8_t>>> loads{};
+    std::vector<std::pair<uint16_t, std::vector<uint8_t>>> expects{};
+    // either the program reaches `end` after exactly `cycles` cycles or it just runs for `run` cycles
+    std::optional<uint16_t> end{};
+    uint64_t cycles = 0u;
+    uint64_t run = 0u;
+    // raylib key codes, every key is pressed and released at the cycle
+    std::vector<std::pair<uint64_t, KeyboardKey>> keys{};
+    std::vector<uint8_t> gpu_text{};
+};
+
+struct Run {
+    uint64_t cpu_cycles = 0u;
+    uint64_t gpu_cycles = 0u;
+    double seconds = 0.0;
+    std::vector<std::string> errors{};
+};
+
+struct Result {
+    std::string name;
+    uint64_t runs;
+    double cycles_per_second;
+    double frames_per_second;
+};
+
+auto parse_options(int argc, char **argv) -> std::optional<Options> {
+    auto options = Options{};
+
+    for (auto i = 1; i < argc; i++) {
+        const auto arg = std::string_view{argv[i]};
+        const auto has_value = i + 1 < argc;
+
+        if (arg == "--workloads" && has_value) {
+            options.workloads = argv[++i];
+        } else if (arg == "--filter" && has_value) {
+            options.filter = argv[++i];
+        } else if (arg == "--min-time" && has_value) {
+            options.min_time = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--output" && has_value) {
+            options.output = argv[++i];
+        } else if (arg == "--baseline" && has_value) {
+            options.baseline = argv[++i];
+        } else if (arg == "--threshold" && has_value) {
+            options.threshold = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--bus-trace" && has_value) {
+            options.bus_trace = argv[++i];
+        } else if (arg == "--check-only") {
+            options.check_only = true;
+        } else {
+            fmt::println(stderr, "unknown or incomplete argument: {}", arg);
+            return std::nullopt;
+        }
+    }
+
+    return options;
+}
+
+auto read_bytes(std::istringstream &stream) -> std::vector<uint8_t> {
+    auto bytes = std::vector<uint8_t>{};
+    for (auto byte = std::string{}; stream >> byte;) {
+        bytes.push_back(static_cast<uint8_t>(std::stoul(byte, nullptr, 16)));
+    }
+    return bytes;
+}
+
+auto read_workload(const std::filesystem::path &path) -> Workload {
+    auto workload = Workload{.name = path.stem().string()};
+    auto file = std::ifstream{path};
+
+    for (auto line = std::string{}; std::getline(file, line);) {
+        auto stream = std::istringstream{line};
+        auto keyword = std::string{};
+        if (!(stream >> keyword) || keyword.starts_with('#')) {
+            continue;
+        }
+
+        auto number = std::string{};
+        if (keyword == "load" || keyword == "expect") {
+            stream >> number;
+            const auto address = static_cast<uint16_t>(std::stoul(number, nullptr, 16));
+            (keyword == "load" ? workload.loads : workload.expects).emplace_back(address, read_bytes(stream));
+        } else if (keyword == "end") {
+            stream >> number;
+            workload.end = static_cast<uint16_t>(std::stoul(number, nullptr, 16));
+        } else if (keyword == "cycles" || keyword == "run") {
+            stream >> number;
+            (keyword == "cycles" ? workload.cycles : workload.run) = std::stoull(number);
+        } else if (keyword == "key") {
+            auto key = std::string{};
+            stream >> number >> key;
+            workload.keys.emplace_back(std::stoull(number), static_cast<KeyboardKey>(std::stoul(key, nullptr, 16)));
+        } else if (keyword == "gpu_text") {
+            const auto bytes = read_bytes(stream);
+            workload.gpu_text.insert(workload.gpu_text.end(), bytes.begin(), bytes.end());
+        } else {
+            fmt::println(stderr, "{}: unknown keyword {}", path.string(), keyword);
+        }
+    }
+
+    return workload;
+}
+
+auto read_workloads(const Options &options) -> std::vector<Workload> {
+    auto paths = std::vector<std::filesystem::path>{};
+    for (const auto &entry : std::filesystem::directory_iterator{options.workloads}) {
+        if (entry.path().extension() == ".workload" &&
+            entry.path().stem().string().find(options.filter) != std::string::npos) {
+            paths.push_back(entry.path());
+        }
+    }
+    std::ranges::sort(paths);
+
+    auto workloads = std::vector<Workload>{};
+    for (const auto &path : paths) {
+        workloads.push_back(read_workload(path));
+    }
+    return workloads;
+}
+
+auto run_workload(const Workload &workload, bus_trace::Writer *trace_writer = nullptr) -> Run {
+    auto machine = GuestMachine{};
+    machine.trace_writer = trace_writer;
+    auto gpu = Vgpu{};
+    gpu.rst = 0;
+    auto gpu_port = GpuCommandPort{&gpu};
+    machine.gpu = &gpu_port;
+
+    for (const auto &[address, bytes] : workload.loads) {
+        machine.load(address, bytes);
+    }
+
+    // the same clocks as in the simulator
+    auto cpu_clock = Clock{&machine, 4, 0, true};
+    auto gpu_clock = Clock{&gpu_port, 1, 0, true};
+    auto scheduler = ClockScheduler{};
+    scheduler.add_clock(&gpu_clock);
+    scheduler.add_clock(&cpu_clock);
+
+    // the end is given some slack so a workload that got slower is reported with its cycle count
+    const auto budget = workload.end ? workload.cycles * 2u + 1000u : workload.run;
+    auto run = Run{};
+    auto next_key = 0u;
+    auto reached_end = false;
+
+    const auto start = std::chrono::steady_clock::now();
+    while (machine.cycles < budget) {
+        for (; next_key < workload.keys.size() && workload.keys[next_key].first <= machine.cycles; next_key++) {
+            machine.keyboard.send_key(workload.keys[next_key].second, false);
+            machine.keyboard.send_key(workload.keys[next_key].second, true);
+        }
+        // the keyboard's lines are only scheduled while they send
+        machine.keyboard_lines.schedule(scheduler);
+
+        // the PC is past `end` once the final `jmp end` was fetched
+        if (workload.end && machine.pc() == static_cast<uint16_t>(*workload.end + 1u)) {
+            reached_end = true;
+            break;
+        }
+
+        scheduler.advance();
+        run.gpu_cycles++;
+    }
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    run.cpu_cycles = machine.cycles;
+
+    if (workload.end && !reached_end) {
+        run.errors.push_back(fmt::format("did not reach {:04x} within {} cycles", *workload.end, budget));
+    } else if (workload.end && machine.cycles != workload.cycles) {
+        run.errors.push_back(fmt::format("took {} cycles, expected {}", machine.cycles, workload.cycles));
+    }
+
+    for (const auto &[address, bytes] : workload.expects) {
+        for (auto i = 0u; i < bytes.size(); i++) {
+            const auto value = machine.system.read(static_cast<uint16_t>(address + i));
+            if (value != bytes[i]) {
+                run.errors.push_back(fmt::format("[{:04x}] = {:02x}, expected {:02x}", address + i, value, bytes[i]));
+            }
+        }
+    }
+
+    if (machine.gpu_text != workload.gpu_text) {
+        run.errors.push_back(fmt::format("sent {} characters to the GPU, expected {}", machine.gpu_text.size(),
+                                         workload.gpu_text.size()));
+    }
+
+    return run;
+}
+
+auto measure(const Workload &workload, double min_time) -> Result {
+    auto runs = uint64_t{0};
+    auto cpu_cycles = uint64_t{0};
+    auto gpu_cycles = uint64_t{0};
+    auto seconds = 0.0;
+
+    while (seconds < min_time || runs == 0u) {
+        const auto run = run_workload(workload);
+        runs++;
+        cpu_cycles += run.cpu_cycles;
+        gpu_cycles += run.gpu_cycles;
+        seconds += run.seconds;
+    }
+
+    const auto frames = static_cast<double>(gpu_cycles) / static_cast<double>(h_total * v_total);
+    return {workload.name, runs, static_cast<double>(cpu_cycles) / seconds, frames / seconds};
+}
+
+void write_results(const std::string &path, const std::vector<Result> &results) {
+    auto *file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        fmt::println(stderr, "failed to open {}", path);
+        return;
+    }
+
+    // one workload per line, `bench::read_baseline` depends on it
+    fmt::print(file, "{{\n  \"workloads\": [\n");
+    for (auto i = 0u; i < results.size(); i++) {
+        const auto &result = results[i];
+        fmt::print(file, "    {{\"name\": \"{}\", \"runs\": {}, \"cycles_per_second\": {:.1f}, \"frames_per_second\": {:.4f}}}{}\n",
+                   result.name, result.runs, result.cycles_per_second, result.frames_per_second,
+                   i + 1 < results.size() ? "," : "");
+    }
+    fmt::print(file, "  ]\n}}\n");
+    std::fclose(file);
+}
+
+auto main(int argc, char **argv) -> int {
+    auto options = parse_options(argc, argv);
+    if (!options) {
+        return 2;
+    }
+
+    if (!options->baseline) {
+        const auto default_baseline = std::filesystem::path{options->workloads} / "baseline.json";
+        if (std::filesystem::exists(default_baseline)) {
+            options->baseline = default_baseline.string();
+        }
+    }
+    if (options->baseline && !std::filesystem::exists(*options->baseline)) {
+        fmt::println(stderr, "baseline {} not found", *options->baseline);
+        return 2;
+    }
+    if (!options->baseline && !options->check_only && !options->output) {
+        fmt::println(stderr, "no baseline.json in {}, record one with `just workloads-baseline` or pass --baseline",
+                     options->workloads);
+        return 2;
+    }
+
+    const auto workloads = read_workloads(*options);
+    if (workloads.empty()) {
+        fmt::println(stderr, "no workloads in {}", options->workloads);
+        return 2;
+    }
+
+    auto failures = 0u;
+    auto results = std::vector<Result>{};
+    for (const auto &workload : workloads) {
+        auto trace_writer = std::optional<bus_trace::Writer>{};
+        if (options->bus_trace) {
+            const auto path = std::filesystem::path{*options->bus_trace} / (workload.name + ".bustrace");
+            if (!trace_writer.emplace(path.string()).is_open()) {
+                fmt::println(stderr, "failed to open {}", path.string());
+                return 2;
+            }
+        }
+
+        const auto run = run_workload(workload, trace_writer ? &*trace_writer : nullptr);
+        trace_writer.reset();
+        if (!run.errors.empty()) {
+            failures++;
+            fmt::println("{:<16} FAILED", workload.name);
+            for (const auto &error : run.errors) {
+                fmt::println("    {}", error);
+            }
+            continue;
+        }
+
+        if (options->check_only) {
+            fmt::println("{:<16} {:>8} cycles  ok", workload.name, run.cpu_cycles);
+            continue;
+        }
+
+        const auto result = measure(workload, options->min_time);
+        fmt::println("{:<16} {:>8} cycles {:>14.0f} cycles/s {:>10.3f} frames/s {:>6} runs", workload.name,
+                     run.cpu_cycles, result.cycles_per_second, result.frames_per_second, result.runs);
+        results.push_back(result);
+    }
+
+    if (options->output) {
+        write_results(*options->output, results);
+    }
+
+    if (!options->baseline || options->check_only) {
+        return failures == 0u ? 0 : 1;
+    }
+
+    const auto baseline = bench::read_baseline(*options->baseline, "cycles_per_second");
+    auto regressions = 0u;
+    auto missing = 0u;
+
+    fmt::println("\ncompared to {} (threshold {:.0f}%):", *options->baseline, options->threshold * 100.0);
+    for (const auto &result : results) {
+        const auto it = baseline.find(result.name);
+        if (it == baseline.end() || it->second <= 0.0) {
+            missing++;
+            fmt::println("{:<16} NO BASELINE", result.name);
+            continue;
+        }
+
+        const auto change = result.cycles_per_second / it->second - 1.0;
+        const auto regressed = change < -options->threshold;
+        regressions += regressed ? 1u : 0u;
+        fmt::println("{:<16} {:>+8.1f}%{}", result.name, change * 100.0, regressed ? "  REGRESSION" : "");
+    }
+
+    return failures == 0u && regressions == 0u && missing == 0u ? 0 : 1;
+}
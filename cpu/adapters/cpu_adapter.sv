@@ -16,7 +16,12 @@ module cpu_adapter(
     output wire [7:0] bus_out
 );
 
+`ifdef MUX_BUSES
+    wire [7:0] cpu_data_out;
+    wire cpu_data_out_en;
+`else
     wire [7:0] bus;
+`endif
 
     cpu cpu(
         .clk(clk),
@@ -31,11 +36,22 @@ module cpu_adapter(
         .reg_mar_load(reg_mar_load),
         .addr_bus(addr_bus),
         .int_bus(int_bus),
+`ifdef MUX_BUSES
+        .data_in(bus_in),
+        .data_in_en(bus_in_en),
+        .data_out(cpu_data_out),
+        .data_out_en(cpu_data_out_en)
+`else
         .data_bus(bus)
+`endif
     );
 
+`ifdef MUX_BUSES
+    assign bus_out = cpu_data_out_en ? cpu_data_out : bus_in_en ? bus_in : 8'h00;
+`else
     assign bus = bus_in_en ? bus_in : 8'hZ;
     assign bus_out = bus;
+`endif
 
     initial begin
         $dumpfile("dump.fst");
@@ -1,3 +1,5 @@
+`include "sim_log.v"
+
 module ram #(
     parameter ADDR_WIDTH = 17
 )(
@@ -15,7 +17,7 @@ module ram #(
     always_ff @(negedge write_enable or address) begin
         /* verilator lint_off SYNCASYNCNET */
         if (~chip_enable & chip_enable2 & ~write_enable) begin
-            $display("[ram] wrote = %02x @ %04x", data, address);
+            `SIM_LOG(`LOG_SRC_RAM_WRITE, address, data);
             storage[address] <= data;
         end
         /* verilator lint_on SYNCASYNCNET */
@@ -47,7 +47,12 @@ logic [7:0] data_bus;
 reg [4:0] flags_reg;
 
 assign flags_out = { 3'b000, flags_reg };
+`ifdef MUX_BUSES
+// the parent muxes this onto the bus whenever `alu_out` or `reg_f_out` is active
+assign data_out = ~alu_out ? data_bus : { 3'b000, flags_reg };
+`else
 assign data_out = ~alu_out ? data_bus : ~reg_f_out ? { 3'b000, flags_reg } : 8'hZ;
+`endif
 
 always_latch begin
     if (reg_f_load) begin
@@ -1,4 +1,5 @@
 `include "include/signals.v"
+`include "sim_log.v"
 `include "basics/counter.v"
 `include "basics/sr_latch.sv"
 
@@ -113,7 +114,7 @@ counter #( .width(4) ) mcc (
 );
 
 always @(posedge reg_ir_load or posedge reg_ir_load_override or negedge rst) begin
-    $display("data = %02h", data);
+    `SIM_LOG(`LOG_SRC_IR_LOAD, data, 0);
     inst_reg <= rom_cjmp[int_inst_bus];
 end
 
@@ -11,7 +11,14 @@ module cpu (
     output wire reg_mar_load,
     output wire [15:0] addr_bus,
     output wire [4:0] int_bus,
+`ifdef MUX_BUSES
+    input wire [7:0] data_in,
+    input wire data_in_en,
+    output wire [7:0] data_out,
+    output wire data_out_en
+`else
     inout wire [7:0] data_bus
+`endif
 );
     // TODO przejrzeć specyfikacje naszych fizycznych układów i ustalić gdzie jaki jest wymagany stan wejścia - szczególnie dla sygnałów
 
@@ -21,10 +28,21 @@ module cpu (
         $monitor("[cpu/inter] clk = %1b, data = %02h, bus = %02h", clk, data_bus, bus);
     end*/
 
+`ifdef MUX_BUSES
+    // With MUX_BUSES every bus is a priority mux over the same output enables the
+    // tristate buffers use. The microcode never enables two drivers at once, so the
+    // priority order does not matter - it only removes the Z resolution (and the
+    // combinational settle loops it causes) from the verilated model.
+    wire [7:0] bus /* verilator public_flat_rd */;
+    wire [7:0] bus_base;
+    wire [15:0] addr_base;
+`else
     /* verilator lint_off UNOPTFLAT */
-    wire [7:0] bus;
+    wire [7:0] bus /* verilator public_flat_rd */;
     /* verilator lint_on UNOPTFLAT */
-    wire [7:0] flags;
+`endif
+    // bus and flags are read by the trace recorder (simulator/trace)
+    wire [7:0] flags /* verilator public_flat_rd */;
     wire [15:0] addr;
     /* verilator lint_off UNUSEDSIGNAL */
     wire [4:0] irq_no;
@@ -46,7 +64,11 @@ module cpu (
         .irq_no(irq_no)
     );
 
-    assign addr = signals[`INT_ADDRESS_OUT] ? { {12{1'b1}}, (irq_no[3] | irq_no[4]), (~irq_no[4] & ~irq_no[3] & irq_no[1]) | (~irq_no[4] & ~irq_no[3] & irq_no[2]), (~irq_no[3] & ~irq_no[1]) | (~irq_no[3] & irq_no[2]) | irq_no[4], 1'b0 } : 16'hZ;
+    wire [15:0] int_addr;
+    assign int_addr = { {12{1'b1}}, (irq_no[3] | irq_no[4]), (~irq_no[4] & ~irq_no[3] & irq_no[1]) | (~irq_no[4] & ~irq_no[3] & irq_no[2]), (~irq_no[3] & ~irq_no[1]) | (~irq_no[3] & irq_no[2]) | irq_no[4], 1'b0 };
+`ifndef MUX_BUSES
+    assign addr = signals[`INT_ADDRESS_OUT] ? int_addr : 16'hZ;
+`endif
 
     // PROGRAM COUNTER
     wire [15:0] pc_out;
@@ -58,11 +80,13 @@ module cpu (
         .in(addr),
         .out(pc_out)
     );
+`ifndef MUX_BUSES
     tristate_buffer #(.width(16)) pc_to_bus(
         .data_in(pc_out),
         .enable(~signals[`PC_OUT]),
         .data_out(addr)
     );
+`endif
 
     // STACK COUNTER
     wire [15:0] stc_out;
@@ -74,11 +98,13 @@ module cpu (
         .in(addr_bus),
         .out(stc_out)
     );
+`ifndef MUX_BUSES
     tristate_buffer #(.width(16)) stc_to_bus (
         .data_in(stc_out),
         .enable(~signals[`STC_OUT]),
         .data_out(addr_bus)
     );
+`endif
 
     // ALU
     wire [7:0] a_out /* verilator public_flat */;
@@ -97,6 +123,10 @@ module cpu (
         .data_out(b_out)
     );
 
+`ifdef MUX_BUSES
+    wire [7:0] alu_data_out;
+`endif
+
     alu alu_unit (
         .alu_out(signals[`ALU_OUT]),
         .reg_f_out(signals[`REG_F_OUT]),
@@ -104,11 +134,22 @@ module cpu (
         .opcode(signals[`ALU_OPC_4:`ALU_OPC_0]),
         .reg_a(a_out),
         .reg_b(b_out),
+`ifdef MUX_BUSES
+        .data_out(alu_data_out),
+`else
         .data_out(bus),
+`endif
         .flags_out(flags)
     );
 
     // TEMPORARY REGISTER
+`ifdef MUX_BUSES
+    wire [7:0] tmp_data_out;
+    wire tmp_data_out_en;
+    wire [15:0] tmp_address_out;
+    wire tmp_address_out_en;
+`endif
+
     tmp tmp(
         .reg_tmph_data_dir(signals[`REG_TMPH_DATA_DIR]),
         .reg_tmph_pass_data(signals[`REG_TMPH_PASS_DATA]),
@@ -120,16 +161,43 @@ module cpu (
         .reg_tmpl_out(signals[`REG_TMPL_OUT]),
         .reg_tmp_pass_address(signals[`REG_TMP_PASS_ADDRESS]),
         .reg_tmp_address_dir(signals[`REG_TMP_ADDRESS_DIR]),
+`ifdef MUX_BUSES
+        .data_in(bus_base),
+        .data_out(tmp_data_out),
+        .data_out_en(tmp_data_out_en),
+        .address_in(addr_base),
+        .address_out(tmp_address_out),
+        .address_out_en(tmp_address_out_en)
+`else
         .data(bus),
         .address(addr)
+`endif
     );
 
     wire cpu_out;
     assign cpu_out = reg_mbr_word_dir & mem_out;
 
+`ifdef MUX_BUSES
+    // TMP is the only driver that can also read the bus it drives, it gets the buses
+    // without its own contribution (it adds that back internally) so there is no loop
+    assign bus_base = (~signals[`ALU_OUT] | ~signals[`REG_F_OUT]) ? alu_data_out :
+                      (~cpu_out & data_in_en) ? data_in :
+                      8'h00;
+    assign bus = tmp_data_out_en ? tmp_data_out : bus_base;
+
+    assign addr_base = signals[`INT_ADDRESS_OUT] ? int_addr :
+                       ~signals[`PC_OUT] ? pc_out :
+                       16'h0000;
+    assign addr = tmp_address_out_en ? tmp_address_out : addr_base;
+
+    assign data_out = bus;
+    assign data_out_en = cpu_out;
+    assign addr_bus = ~signals[`STC_OUT] ? stc_out : addr;
+`else
     assign data_bus = cpu_out ? bus : 8'hZ;
     assign bus = ~cpu_out ? data_bus : 8'hZ;
     assign addr_bus = addr;
+`endif
     
     assign zero_page = signals[`ZERO_PAGE];
     assign mem_part = signals[`MEM_PART];
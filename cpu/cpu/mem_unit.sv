@@ -1,3 +1,4 @@
+`include "sim_log.v"
 `include "basics/ram.sv"
 
 module mem_unit(
@@ -26,17 +27,13 @@ module mem_unit(
         .data(data_bus)
     );
 
-    initial begin
-        $display("[mem] mar = %04x, mbr = %02x", mar, mbr);
-    end
-
     always_ff @(posedge reg_mar_load) begin
         mar <= address;
-        $display("[mem] mar = %04x, mbr = %02x", mar, mbr);
+        `SIM_LOG(`LOG_SRC_MAR_LOAD, address, 0);
     end
     always_ff @(posedge reg_mbr_load) begin
         mbr <= data;
-        $display("[mem] mar = %04x, mbr = %02x", mar, mbr);
+        `SIM_LOG(`LOG_SRC_MBR_LOAD, data, 0);
     end
     
     assign data = ~reg_mbr_word_dir ? data_bus : 8'hZ; 
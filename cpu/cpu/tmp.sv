@@ -9,8 +9,17 @@ module tmp(
     input wire reg_tmpl_out, // active low
     input wire reg_tmp_pass_address, // active low
     input wire reg_tmp_address_dir,
+`ifdef MUX_BUSES
+    input wire [7:0] data_in,
+    output wire [7:0] data_out,
+    output wire data_out_en,
+    input wire [15:0] address_in,
+    output wire [15:0] address_out,
+    output wire address_out_en
+`else
     inout wire [7:0] data,
     inout wire [15:0] address
+`endif
 );
 
 // data_dir
@@ -20,6 +29,38 @@ module tmp(
 reg [7:0] tmph;
 reg [7:0] tmpl;
 
+`ifdef MUX_BUSES
+
+// Same behaviour as the tristate version below, but every net has exactly one driver.
+// A half never drives the bus it is reading from, so the value put on the data bus is
+// built without looking at the data bus (and the same for the address bus) - this keeps
+// the logic free of combinational loops.
+
+wire tmph_to_data = ~reg_tmph_pass_data & ~reg_tmph_data_dir;
+wire tmpl_to_data = ~reg_tmpl_pass_data & ~reg_tmpl_data_dir;
+wire tmp_to_address = ~reg_tmp_pass_address & ~reg_tmp_address_dir;
+wire address_to_tmp = ~reg_tmp_pass_address & reg_tmp_address_dir;
+
+wire [7:0] tmph_data_src = ~reg_tmph_out ? tmph : address_to_tmp ? address_in[15:8] : 8'h00;
+wire [7:0] tmpl_data_src = ~reg_tmpl_out ? tmpl : address_to_tmp ? address_in[7:0] : 8'h00;
+
+wire [7:0] data = tmph_to_data ? tmph_data_src : tmpl_to_data ? tmpl_data_src : data_in;
+
+wire [7:0] tmph_address_src = ~reg_tmph_out ? tmph : reg_tmph_data_dir ? data : 8'h00;
+wire [7:0] tmpl_address_src = ~reg_tmpl_out ? tmpl : reg_tmpl_data_dir ? data : 8'h00;
+
+wire [15:0] address = tmp_to_address ? { tmph_address_src, tmpl_address_src } : address_in;
+
+wire [7:0] tmph_bus = ~reg_tmph_out ? tmph : reg_tmph_data_dir ? data : address_to_tmp ? address[15:8] : 8'h00;
+wire [7:0] tmpl_bus = ~reg_tmpl_out ? tmpl : reg_tmpl_data_dir ? data : address_to_tmp ? address[7:0] : 8'h00;
+
+assign data_out = data;
+assign data_out_en = tmph_to_data | tmpl_to_data;
+assign address_out = address;
+assign address_out_en = tmp_to_address;
+
+`else
+
 /* verilator lint_off UNOPTFLAT */
 wire [7:0] tmph_bus;
 wire [7:0] tmpl_bus;
@@ -40,6 +81,8 @@ assign tmpl_bus = ~reg_tmpl_out ? tmpl : 8'hZ;
 
 assign address = ~reg_tmp_pass_address ? (~reg_tmp_address_dir ? { tmph_bus, tmpl_bus } : 16'hZ) : 16'hZ;
 
+`endif
+
 always_ff @(posedge reg_tmph_load) tmph <= tmph_bus;
 always_ff @(posedge reg_tmpl_load) tmpl <= tmpl_bus;
 
@@ -0,0 +1,21 @@
+`ifndef SIM_LOG_V
+`define SIM_LOG_V
+
+// Source ids, must match `sim_log::Source` in simulator/log/sim_log.hpp
+`define LOG_SRC_IR_LOAD         'd0
+`define LOG_SRC_RAM_WRITE       'd1
+`define LOG_SRC_MAR_LOAD        'd2
+`define LOG_SRC_MBR_LOAD        'd3
+`define LOG_SRC_GPU_RAM_WRITE   'd4
+`define LOG_SRC_GPU_CURSOR_MOVE 'd5
+
+// In the verilated build events go through DPI into a binary ring buffer (formatted offline),
+// everywhere else they fall back to plain `$display`
+`ifdef VERILATOR
+import "DPI-C" function void sim_log_event(input int source, input longint timestamp, input int a, input int b);
+`define SIM_LOG(src, a, b) sim_log_event(src, $time, 32'(a), 32'(b))
+`else
+`define SIM_LOG(src, a, b) $display("[%0d] %0t: a = %0h, b = %0h", src, $time, a, b)
+`endif
+
+`endif
@@ -1,6 +1,7 @@
 `include "gpu/modcounter.sv"
 `include "basics/counter.v"
 `include "basics/shift_reg.sv"
+`include "sim_log.v"
 `define DISPLAY_WIDTH 640
 `define DISPLAY_HEIGHT 480
 `define TEXT_MODE_WIDTH 80
@@ -14,6 +15,11 @@
 `define SIG_DISPLAY 2'b10
 `define SIG_CLEAR 2'b11
 
+// SIG_DISPLAY operations, in interrupt_data_in[7:6]
+`define DISPLAY_SCROLL 2'b00
+`define DISPLAY_PAGES  2'b01
+`define DISPLAY_FLIP   2'b10
+
 /* verilator lint_off UNUSEDSIGNAL */
 
 module gpu(
@@ -26,7 +32,12 @@ module gpu(
     output reg [7:0] green,
     output reg [7:0] blue,
     output logic hsync,
-    output logic vsync
+    output logic vsync,
+    // a command that is sent while this is high can be lost, see GpuCommandPort
+    output logic busy,
+    // the page that is scanned out, and whether writes go to the other one
+    output logic display_page,
+    output logic double_buffered
 );
 
 typedef enum logic [1:0] {
@@ -36,12 +47,13 @@ typedef enum logic [1:0] {
     DISPLAY     = 2'b11
 } Region;
 
-Region h_region, next_h_region;
-Region v_region, next_v_region;
+// the simulator reads the timing state to sync up without scanning for sync pulses
+Region h_region /* verilator public_flat_rd */, next_h_region;
+Region v_region /* verilator public_flat_rd */, next_v_region;
 
-reg [9:0] h_counter;
+reg [9:0] h_counter /* verilator public_flat_rd */;
 reg rst_h_counter, next_rst_h_counter;
-reg [8:0] v_counter;
+reg [8:0] v_counter /* verilator public_flat_rd */;
 reg rst_v_counter, next_rst_v_counter;
 
 wire next_line;
@@ -121,13 +133,17 @@ always_ff @(posedge clk) begin
         v_region <= next_v_region;
 end
 
-reg  [12:0] char_write_addr;
+// Both buffers hold two pages, the page is the top address bit. With double buffering the cells are written to the
+// page that is not displayed and DISPLAY_FLIP swaps the pages at the next vsync.
+wire write_page;
+
+reg  [13:0] char_write_addr;
 reg  [7:0]  char_in;
 reg         write_char;
-wire [12:0] char_read_addr;
+wire [13:0] char_read_addr;
 wire [7:0]  char;
 
-ram #(.ADDR_WIDTH(13)) char_buf(
+ram #(.ADDR_WIDTH(14)) char_buf(
     .clk(clk),
     .data(char_in),
     .write_addr(char_write_addr),
@@ -149,15 +165,15 @@ always_ff @(posedge clk)
 
 wire [12:0] cursor;
 
-assign char_read_addr = cursor;
+assign char_read_addr = { display_page, cursor };
 
-reg [12:0] color_write_addr;
+reg [13:0] color_write_addr;
 reg [7:0]  color_in;
 reg        write_color;
-wire [12:0] color_read_addr;
+wire [13:0] color_read_addr;
 wire [7:0]  color;
 
-ram #(.ADDR_WIDTH(13)) color_buf(
+ram #(.ADDR_WIDTH(14)) color_buf(
     .clk(clk),
     .data(color_in),
     .write_addr(color_write_addr),
@@ -166,7 +182,7 @@ ram #(.ADDR_WIDTH(13)) color_buf(
     .we(write_color)
 );
 
-assign color_read_addr = cursor;
+assign color_read_addr = { display_page, cursor };
 
 reg [6:0] h_cursor;
 reg [12:0] v_cursor;
@@ -189,7 +205,16 @@ always_ff @(posedge clk)
         end else h_cursor <= '0;
     end
 
-assign cursor = v_cursor + { 5'h00, h_cursor };
+// Hardware scrolling: screen row r shows char_buf row (r + scroll_row) mod 60. Writes go through the same offset,
+// so the write cursor keeps addressing screen cells.
+reg [5:0] scroll_row /* verilator public_flat_rd */;
+wire [12:0] scroll_offset = 13'(scroll_row) * 13'd80;
+
+function automatic [12:0] wrap_cell(input [13:0] cell);
+    wrap_cell = cell >= 14'd4800 ? 13'(cell - 14'd4800) : cell[12:0];
+endfunction
+
+assign cursor = wrap_cell(14'(v_cursor) + 14'(scroll_offset)) + { 6'h00, h_cursor };
 
 reg [7:0] glyph_rom [2048];
 reg [4:0][2:0] palette_rom [32];
@@ -233,15 +258,60 @@ reg char_write_done;
 reg [12:0] write_cursor;
 reg [7:0] pending_char;
 
+reg clear_request;
+reg clearing;
+reg clear_done;
+reg [12:0] clear_addr;
+reg [7:0] clear_char;
+
+reg flip_request;
+reg flip_done;
+
+// the write pipeline takes three edges from the request until it is idle again, a clear 4802 and a flip waits for
+// the next vsync - nothing can be written to the page that is about to be shown
+assign busy = char_write_request || char_write_pending || char_write_done || clear_request || clearing || clear_done
+    || flip_request || flip_done;
+
+assign write_page = double_buffered ? !display_page : display_page;
+
+always_ff @(posedge clk) begin
+    if (flip_request && !flip_done && vsync) begin
+        display_page <= !display_page;
+        flip_done <= 1'b1;
+    end else if (!flip_request)
+        flip_done <= 1'b0;
+end
+
+// SIG_CLEAR fills the write page of char_buf through its write port, one cell per cycle. The port is separate from
+// the one the display reads, so this runs during the visible area too.
 always_ff @(posedge clk) begin
-    if (char_write_request) begin
+    if (clear_request && !clearing && !clear_done) begin
+        clearing <= 1'b1;
+        clear_addr <= '0;
+    end else if (clearing) begin
+        clear_addr <= clear_addr + 1;
+        if (clear_addr == 4799) begin
+            clearing <= 1'b0;
+            clear_done <= 1'b1;
+        end
+    end else if (!clear_request)
+        clear_done <= 1'b0;
+end
+
+always_ff @(posedge clk) begin
+    if (clearing) begin
+        char_in <= clear_char;
+        char_write_addr <= { write_page, clear_addr };
+        write_char <= 1'b1;
+    end else if (char_write_request) begin
         char_in <= pending_char;
-        char_write_addr <= write_cursor;
+        char_write_addr <= { write_page, wrap_cell(14'(write_cursor) + 14'(scroll_offset)) };
         char_write_pending <= 1'b1;
         write_char <= 1'b1;
     end else begin
         char_write_pending <= 1'b0;
         char_write_done <= 1'b0;
+        write_char <= 1'b0;
     end
 
     if (char_write_pending) begin
@@ -250,7 +320,7 @@ always_ff @(posedge clk) begin
     end
 end
 
-always_latch @(interrupt_enable or char_write_done) begin
+always_latch @(interrupt_enable or char_write_done or clear_done or flip_done) begin
     if (interrupt_enable) begin
         case (interrupt_code_in)
             `SIG_STORE_BYTE: begin
@@ -267,10 +337,31 @@ always_latch @(interrupt_enable or char_write_done) begin
                     write_cursor = write_cursor + 80*(13'(signed'(interrupt_data_in[5:0]))); // NOTE: multiply
                 if (write_cursor >= 4800)
                     write_cursor = 0;
-                $display("write cursor moved cursor = %04xh", write_cursor);
+                `SIM_LOG(`LOG_SRC_GPU_CURSOR_MOVE, write_cursor, 0);
+            end
+            `SIG_DISPLAY: begin
+                case (interrupt_data_in[7:6])
+                    `DISPLAY_SCROLL:
+                        scroll_row = interrupt_data_in[5:0] >= 60 ? interrupt_data_in[5:0] - 6'd60 : interrupt_data_in[5:0];
+                    `DISPLAY_PAGES:
+                        double_buffered = interrupt_data_in[0];
+                    `DISPLAY_FLIP:
+                        flip_request = 1'b1;
+                    default: ;
+                endcase
+            end
+            `SIG_CLEAR: begin
+                // the next SIG_STORE_BYTE goes to the top left cell
+                clear_request = 1'b1;
+                clear_char = interrupt_data_in;
+                write_cursor = 4799;
             end
         endcase
-    end else if (char_write_done) char_write_request = 1'b0;
+    end else begin
+        if (char_write_done) char_write_request = 1'b0;
+        if (clear_done) clear_request = 1'b0;
+        if (flip_done) flip_request = 1'b0;
+    end
 end
 
 // TODO: proper signal triggered reset
@@ -282,12 +373,24 @@ initial begin
     rst_h_counter = 0;
     rst_v_counter = 0;
     write_char = 0;
+    char_write_request = 0;
+    char_write_pending = 0;
+    char_write_done = 0;
+    clear_request = 0;
+    clearing = 0;
+    clear_done = 0;
+    flip_request = 0;
+    flip_done = 0;
+    display_page = 0;
+    double_buffered = 0;
     write_cursor = 4799;
     px_counter = 0;
     glyph_bit_sel = 0;
     color_buf.mem[0] = 8'hFF;
+    color_buf.mem[14'h2000] = 8'hFF;
     h_cursor = 0;
     v_cursor = 0;
+    scroll_row = 0;
 end
 
 initial begin
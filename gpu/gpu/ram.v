@@ -1,3 +1,5 @@
+`include "sim_log.v"
+
 /**
  * RAM block
  *
@@ -16,7 +18,7 @@ module ram#(
     output reg [DATA_WIDTH-1:0] out
 );
 
-reg [DATA_WIDTH-1:0] mem [1<<ADDR_WIDTH];
+reg [DATA_WIDTH-1:0] mem [1<<ADDR_WIDTH] /* verilator public_flat_rd */;
 
 always @(posedge clk) begin
     if (we)
@@ -24,7 +26,7 @@ always @(posedge clk) begin
     out = mem[read_addr];
 
     if (we) begin
-        $display("[ram] wrote %02xh to %06xh", data, write_addr);
+        `SIM_LOG(`LOG_SRC_GPU_RAM_WRITE, write_addr, data);
     end
 end
 
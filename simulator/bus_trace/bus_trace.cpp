@@ -0,0 +1,146 @@
+#include "bus_trace.hpp"
+#include <chrono>
+
+namespace {
+    constexpr uint8_t has_data_bit = 1u << 4;
+
+    void put_varint(uint64_t value, std::vector<uint8_t> &out) {
+        while (value >= 0x80u) {
+            out.push_back(static_cast<uint8_t>(value | 0x80u));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    auto get_varint(const std::vector<uint8_t> &in, std::size_t &pos) -> std::optional<uint64_t> {
+        auto value = uint64_t{0};
+        for (auto shift = 0u; shift < 64u; shift += 7u) {
+            if (pos >= in.size()) {
+                return std::nullopt;
+            }
+            const auto byte = in[pos++];
+            value |= static_cast<uint64_t>(byte & 0x7Fu) << shift;
+            if ((byte & 0x80u) == 0u) {
+                return value;
+            }
+        }
+        return std::nullopt;
+    }
+
+    auto zigzag(int32_t value) -> uint64_t {
+        return static_cast<uint32_t>(value < 0 ? ~(value << 1) : value << 1);
+    }
+
+    auto unzigzag(uint64_t value) -> int32_t {
+        return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1u);
+    }
+}
+
+auto bus_trace::preload(uint16_t address, std::span<const uint8_t> bytes, uint64_t cycle) -> std::vector<Transaction> {
+    auto transactions = std::vector<Transaction>{};
+    transactions.reserve(bytes.size() * 3u);
+    for (const auto byte : bytes) {
+        transactions.push_back({cycle, address, 0u, Kind::MarLoad, true, false});
+        transactions.push_back({cycle, address, byte, Kind::MbrLoad, true, false});
+        transactions.push_back({cycle, address, byte, Kind::Write, true, false});
+        address++;
+    }
+    return transactions;
+}
+
+void bus_trace::encode(const Transaction &transaction, const Transaction &previous, std::vector<uint8_t> &out) {
+    const auto has_data = transaction.kind != Kind::MarLoad;
+    out.push_back(static_cast<uint8_t>(static_cast<uint8_t>(transaction.kind) | (transaction.zero_page ? 1u << 2 : 0u) |
+                                       (transaction.mem_part ? 1u << 3 : 0u) | (has_data ? has_data_bit : 0u)));
+    put_varint(transaction.cycle - previous.cycle, out);
+    put_varint(zigzag(static_cast<int32_t>(transaction.address) - static_cast<int32_t>(previous.address)), out);
+    if (has_data) {
+        out.push_back(transaction.data);
+    }
+}
+
+bus_trace::Writer::Writer(const std::string &path)
+    : file(record_file::create(path, file_magic)),
+      buffer(std::make_unique<RingBuffer<Transaction, buffer_capacity>>()) {
+    if (file == nullptr) {
+        return;
+    }
+
+    thread = std::thread{[this] { run(); }};
+}
+
+bus_trace::Writer::~Writer() {
+    if (file == nullptr) {
+        return;
+    }
+
+    stop.store(true, std::memory_order_release);
+    thread.join();
+    std::fclose(file);
+}
+
+void bus_trace::Writer::run() {
+    auto previous = Transaction{};
+    auto encoded = std::vector<uint8_t>{};
+
+    const auto drain = [&] {
+        encoded.clear();
+        const auto count = buffer->drain([&](const Transaction &transaction) {
+            encode(transaction, previous, encoded);
+            previous = transaction;
+        });
+        std::fwrite(encoded.data(), 1, encoded.size(), file);
+        transactions.fetch_add(count, std::memory_order_relaxed);
+        return count;
+    };
+
+    while (!stop.load(std::memory_order_acquire)) {
+        if (drain() == 0u) {
+            std::this_thread::sleep_for(std::chrono::microseconds{200});
+        }
+    }
+
+    // everything recorded before the destructor was called
+    drain();
+}
+
+auto bus_trace::read(const std::string &path) -> std::optional<std::vector<Transaction>> {
+    const auto contents = record_file::read_file(path, file_magic);
+    if (!contents) {
+        return std::nullopt;
+    }
+    const auto &bytes = *contents;
+
+    auto trace = std::vector<Transaction>{};
+    auto previous = Transaction{};
+    auto pos = std::size_t{0};
+
+    while (pos < bytes.size()) {
+        const auto header = bytes[pos++];
+        const auto cycle_delta = get_varint(bytes, pos);
+        const auto address_delta = get_varint(bytes, pos);
+        if (!cycle_delta || !address_delta) {
+            return std::nullopt;
+        }
+
+        auto transaction = Transaction{
+            .cycle = previous.cycle + *cycle_delta,
+            .address = static_cast<uint16_t>(previous.address + unzigzag(*address_delta)),
+            .data = 0u,
+            .kind = static_cast<Kind>(header & 0b11u),
+            .zero_page = (header & (1u << 2)) != 0u,
+            .mem_part = (header & (1u << 3)) != 0u,
+        };
+        if ((header & has_data_bit) != 0u) {
+            if (pos >= bytes.size()) {
+                return std::nullopt;
+            }
+            transaction.data = bytes[pos++];
+        }
+
+        trace.push_back(transaction);
+        previous = transaction;
+    }
+
+    return trace;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "record_file.hpp"
+#include "ring_buffer.hpp"
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Trace of every transaction between the CPU and its memory unit.
+//
+// `Writer::record` only pushes a fixed size `Transaction` into a lock-free ring buffer, a background thread
+// encodes and writes it. On disk every transaction is delta encoded against the previous one:
+//
+//   header  kind (bits 0-1), zero_page (bit 2), mem_part (bit 3), data follows (bit 4)
+//   varint  cycles since the previous transaction
+//   varint  zigzag encoded address change
+//   byte    data, only for MBR loads, reads and writes
+//
+// after `file_magic`. Sequential code costs 3-4 bytes per transaction. `replay` drives any `MemoryBackend`
+// (see bench/bus_replay.cpp for Vmem_unit) from a trace, so memory models can be benchmarked and checked
+// without the CPU. A replay starts from empty memory, whatever was in memory before the run has to be at the start
+// of the trace as the writes from `preload`.
+
+namespace bus_trace {
+    enum class Kind : uint8_t {
+        MarLoad = 0, // address = new MAR
+        MbrLoad = 1, // data = new MBR, address = MAR
+        Read = 2,    // address = MAR, data = the byte the memory unit returned
+        Write = 3,   // address = MAR, data = the byte written (MBR)
+    };
+
+    struct Transaction {
+        uint64_t cycle;
+        uint16_t address;
+        uint8_t data;
+        Kind kind;
+        // as driven by the CPU, zero_page is active low
+        bool zero_page;
+        bool mem_part;
+
+        auto operator==(const Transaction &) const -> bool = default;
+    };
+
+    constexpr static char file_magic[8] = {'B', 'U', 'S', 'T', 'R', 'C', '0', '1'};
+
+    // The transactions that store `bytes` at `address`, MAR and MBR loads and a write per byte at `cycle`
+    auto preload(uint16_t address, std::span<const uint8_t> bytes, uint64_t cycle = 0u) -> std::vector<Transaction>;
+
+    // Appends the encoding of `transaction` to `out`, `previous` is the transaction before it (zeroed at the start)
+    void encode(const Transaction &transaction, const Transaction &previous, std::vector<uint8_t> &out);
+
+    struct Writer {
+        explicit Writer(const std::string &path);
+        ~Writer();
+
+        Writer(const Writer &) = delete;
+        auto operator=(const Writer &) -> Writer & = delete;
+
+        auto is_open() const -> bool { return file != nullptr; }
+
+        // Called from the simulation thread, waits only when the writer thread fell a whole buffer behind
+        void record(const Transaction &transaction) {
+            while (!buffer->push(transaction)) {
+                std::this_thread::yield();
+            }
+        }
+
+        auto written() const -> uint64_t { return transactions.load(std::memory_order_relaxed); }
+
+      private:
+        constexpr static std::size_t buffer_capacity = 1u << 16;
+
+        void run();
+
+        std::FILE *file;
+        std::unique_ptr<RingBuffer<Transaction, buffer_capacity>> buffer;
+        std::atomic<bool> stop{false};
+        std::atomic<uint64_t> transactions{0u};
+        std::thread thread;
+    };
+
+    // Reads a whole trace, returns nullopt when the file is missing, not a trace or truncated
+    auto read(const std::string &path) -> std::optional<std::vector<Transaction>>;
+
+    template <typename T>
+    concept MemoryBackend = requires(T backend, uint16_t address, uint8_t data, bool zero_page, bool mem_part) {
+        backend.load_mar(address);
+        backend.load_mbr(data);
+        { backend.read(zero_page, mem_part) } -> std::convertible_to<uint8_t>;
+        backend.write(zero_page, mem_part);
+    };
+
+    struct ReplayResult {
+        uint64_t transactions = 0u;
+        // reads that returned something else than in the trace
+        uint64_t mismatches = 0u;
+        std::optional<Transaction> first_mismatch{};
+    };
+
+    template <MemoryBackend Backend> auto replay(const std::vector<Transaction> &trace, Backend &backend) -> ReplayResult {
+        auto result = ReplayResult{};
+
+        for (const auto &transaction : trace) {
+            switch (transaction.kind) {
+            case Kind::MarLoad:
+                backend.load_mar(transaction.address);
+                break;
+            case Kind::MbrLoad:
+                backend.load_mbr(transaction.data);
+                break;
+            case Kind::Read:
+                if (static_cast<uint8_t>(backend.read(transaction.zero_page, transaction.mem_part)) != transaction.data) {
+                    if (result.mismatches == 0u) {
+                        result.first_mismatch = transaction;
+                    }
+                    result.mismatches++;
+                }
+                break;
+            case Kind::Write:
+                backend.write(transaction.zero_page, transaction.mem_part);
+                break;
+            }
+            result.transactions++;
+        }
+
+        return result;
+    }
+}
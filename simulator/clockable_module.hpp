@@ -1,5 +1,7 @@
 #pragma once
 
+#include "perf_counters.hpp"
+#include "profiler.hpp"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
@@ -17,6 +19,13 @@ struct ClockBase {
     virtual void tick() = 0;
     virtual void advance(uint32_t delta) = 0;
     virtual auto get_time_till_next_tick() const -> uint32_t = 0;
+
+    // Shown in the performance HUD
+    const char *name = "clock";
+    profiler::Stat eval_stats{};
+    profiler::Stat posedges{};
+    // Hardware counters attributed to this domain's eval(), see perf_counters.hpp
+    perf::CounterGroup *perf_group = nullptr;
 };
 
 template <ClockableModule T> struct Clock : ClockBase {
@@ -32,7 +41,14 @@ template <ClockableModule T> struct Clock : ClockBase {
         } else {
             module->clk = is_posedge;
         }
-        module->eval();
+        if (is_posedge) {
+            PROFILE_COUNT(posedges);
+        }
+        {
+            PROFILE_SCOPE(eval_stats);
+            const perf::ScopedGroup perf_scope{perf_group};
+            module->eval();
+        }
         is_posedge = !is_posedge;
         if (current_period() == 0u) {
             tick();
@@ -69,20 +85,28 @@ template <ClockableModule T> struct Clock : ClockBase {
 
 struct ClockScheduler {
     void add_clock(ClockBase *clock) { clocks.push_back(clock); }
+    void remove_clock(ClockBase *clock) { std::erase(clocks, clock); }
 
     void advance() {
         auto min_time = std::numeric_limits<uint32_t>::max();
 
-        for (auto clock : clocks) {
-            const auto time = clock->get_time_till_next_tick();
-            min_time = std::min(min_time, time);
+        // only the scan is timed, the evals below are counted by their clock domains
+        {
+            PROFILE_SCOPE(profiler::zones.scheduler_advance);
+            for (auto clock : clocks) {
+                const auto time = clock->get_time_till_next_tick();
+                min_time = std::min(min_time, time);
+            }
         }
 
+        time += min_time;
         for (auto clock : clocks) {
             clock->advance(min_time);
         }
     }
 
     std::vector<ClockBase *> clocks;
+    // sum of all advances in the units of the clock periods, already updated while the clocks tick
+    uint64_t time = 0u;
 };
 
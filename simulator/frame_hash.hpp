@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#include <raylib.h>
+
+// FNV-1a over the visible pixels of a frame, as drawn by `VGASimulator::process_vga_frame`. Shared by
+// bench/gpu_replay and the golden frame tests so their hashes can be compared.
+struct FrameHash {
+    uint64_t value = 0xcbf29ce484222325u;
+
+    void add(uint8_t byte) {
+        value ^= byte;
+        value *= 0x100000001b3u;
+    }
+
+    void add(const Color color) {
+        add(color.r);
+        add(color.g);
+        add(color.b);
+    }
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "clockable_module.hpp"
+#include "gpu_stream.hpp"
+#include <cstdint>
+#include <deque>
+#include <string_view>
+
+// Queues GPU commands and sends them from inside the GPU's clock domain - use the port instead of the GPU as the
+// module of the GPU's `Clock`:
+//
+//   auto port = GpuCommandPort{&gpu};
+//   auto gpu_clock = Clock{&port, 1, 0, true};
+//   port.write("hello");
+//
+// A command goes out on the falling edge eval the clock does anyway, so unlike `gpu_stream::send` it costs no
+// extra evals. The next command waits while the GPU reports `busy` (a character write takes three rising edges),
+// commands sent back to back by hand would overwrite the one that is still being written.
+
+template <typename T>
+concept CommandPortGpu = gpu_stream::CommandInput<T> && requires(T gpu) {
+    gpu.clk;
+    gpu.busy;
+};
+
+template <CommandPortGpu Gpu> struct GpuCommandPort {
+    // SIG_DISPLAY operations in the top two bits of the data
+    constexpr static uint8_t display_scroll = 0b00u << 6;
+    constexpr static uint8_t display_pages = 0b01u << 6;
+    constexpr static uint8_t display_flip = 0b10u << 6;
+
+    explicit GpuCommandPort(Gpu *gpu) : gpu(gpu) {}
+
+    auto clk() { return &gpu->clk; }
+
+    void eval() {
+        const auto falling_edge = !gpu->clk;
+        const auto issue = falling_edge && !gpu->busy && !queue.empty();
+
+        if (issue) {
+            const auto command = queue.front();
+            queue.pop_front();
+            gpu->interrupt_enable = 1;
+            gpu->interrupt_code_in = static_cast<uint8_t>(command.code);
+            gpu->interrupt_data_in = command.data;
+            issued++;
+            if (recorder != nullptr && scheduler != nullptr) {
+                recorder->record({.time = scheduler->time, .code = command.code, .data = command.data});
+            }
+        } else if (falling_edge && !queue.empty()) {
+            stalled++;
+        }
+
+        gpu->eval();
+
+        // low again from the next edge on, the GPU latches the command while the enable is high
+        if (issue) {
+            gpu->interrupt_enable = 0;
+        }
+    }
+
+    void push(gpu_stream::Code code, uint8_t data) { queue.push_back({code, data}); }
+
+    // Writes at the cursor and moves it one cell forward
+    void store_byte(uint8_t c) { push(gpu_stream::Code::StoreByte, c); }
+
+    void write(std::string_view text) {
+        for (const auto c : text) {
+            store_byte(static_cast<uint8_t>(c));
+        }
+    }
+
+    // Relative moves, -64..63 columns or -32..31 rows (see SIG_MOVE_CURSOR in gpu/gpu/gpu.sv)
+    void move_cursor_columns(int8_t columns) {
+        push(gpu_stream::Code::MoveCursor, static_cast<uint8_t>(0x80u | (static_cast<uint8_t>(columns) & 0x7Fu)));
+    }
+    void move_cursor_rows(int8_t rows) {
+        push(gpu_stream::Code::MoveCursor, static_cast<uint8_t>(static_cast<uint8_t>(rows) & 0x3Fu));
+    }
+
+    // Fills the whole screen with `fill` and moves the cursor to the top left, one command for the 4800 cells
+    void clear(uint8_t fill = ' ') { push(gpu_stream::Code::Clear, fill); }
+
+    // Hardware scroll: screen row r shows buffer row (r + row) mod 60, writes are offset the same way. Scrolling
+    // one line is `scroll_to(row + 1)` and rewriting the bottom row.
+    void scroll_to(uint8_t row) { push(gpu_stream::Code::Display, static_cast<uint8_t>(display_scroll | (row % 60u))); }
+
+    // With double buffering every write goes to the page that is not shown, `flip` shows it from the next vsync on.
+    // The port holds everything queued after a flip until it happened.
+    void double_buffer(bool enable) { push(gpu_stream::Code::Display, static_cast<uint8_t>(display_pages | enable)); }
+    void flip() { push(gpu_stream::Code::Display, display_flip); }
+
+    auto pending() const -> std::size_t { return queue.size(); }
+    auto empty() const -> bool { return queue.empty(); }
+    // while commands are queued or the GPU is still writing the last one
+    auto busy() const -> bool { return !queue.empty() || gpu->busy; }
+
+    // Every issued command is recorded with the scheduler's time when both are set
+    gpu_stream::Recorder *recorder = nullptr;
+    const ClockScheduler *scheduler = nullptr;
+
+    // commands sent to the GPU, and falling edges a queued command had to wait for the GPU
+    uint64_t issued = 0u;
+    uint64_t stalled = 0u;
+
+  private:
+    struct Queued {
+        gpu_stream::Code code;
+        uint8_t data;
+    };
+
+    Gpu *gpu;
+    std::deque<Queued> queue{};
+};
@@ -0,0 +1,21 @@
+#include "gpu_stream.hpp"
+
+void gpu_stream::Recorder::record(const Command &command) {
+    auto bytes = record_file::Record<record_size>{};
+    record_file::store(&bytes[0], command.time);
+    bytes[8] = static_cast<uint8_t>(command.code);
+    bytes[9] = command.data;
+    writer.write(bytes);
+}
+
+auto gpu_stream::read(const std::string &path) -> std::optional<std::vector<Command>> {
+    return record_file::read_records<record_size>(
+        path, file_magic, [](const record_file::Record<record_size> &bytes) -> std::optional<Command> {
+            if (bytes[8] > static_cast<uint8_t>(Code::Clear)) {
+                return std::nullopt;
+            }
+            return Command{.time = record_file::load<uint64_t>(&bytes[0]),
+                           .code = static_cast<Code>(bytes[8]),
+                           .data = bytes[9]};
+        });
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "clockable_module.hpp"
+#include "record_file.hpp"
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+// The GPU's command stream: every interrupt pulse on `interrupt_enable`/`interrupt_code_in`/`interrupt_data_in`
+// with the `ClockScheduler::time` it was sent at.
+//
+// `Recorder` writes the stream to a file, `ReplayClock` feeds a recorded stream back into a GPU from inside a
+// `ClockScheduler`, so every command arrives at the same point of the frame as when it was recorded. With the same
+// clocks this reproduces the frames without the CPU or the keyboard, see bench/gpu_replay.cpp.
+//
+// File format: `file_magic`, then 10 bytes per command - the time (8 bytes, little endian), code and data. Files with
+// a code outside of `Code` are rejected.
+
+namespace gpu_stream {
+    // interrupt_code_in, SIG_* in gpu/gpu/gpu.sv
+    enum class Code : uint8_t {
+        StoreByte = 0b00,
+        MoveCursor = 0b01,
+        Display = 0b10,
+        Clear = 0b11,
+    };
+
+    struct Command {
+        uint64_t time;
+        Code code;
+        uint8_t data;
+
+        auto operator==(const Command &) const -> bool = default;
+    };
+
+    constexpr static char file_magic[8] = {'G', 'P', 'U', 'C', 'M', 'D', '0', '1'};
+
+    // Any GPU model driven by interrupt pulses, e.g. Vgpu
+    template <typename T>
+    concept CommandInput = requires(T gpu) {
+        gpu.interrupt_enable;
+        gpu.interrupt_code_in;
+        gpu.interrupt_data_in;
+        gpu.eval();
+    };
+
+    template <CommandInput Gpu> void send(Gpu &gpu, Code code, uint8_t data) {
+        gpu.interrupt_enable = 1;
+        gpu.interrupt_code_in = static_cast<uint8_t>(code);
+        gpu.interrupt_data_in = data;
+        gpu.eval();
+        gpu.interrupt_enable = 0;
+        gpu.eval();
+    }
+
+    constexpr static std::size_t record_size = 10u;
+
+    struct Recorder {
+        explicit Recorder(const std::string &path) : writer(path, file_magic) {}
+
+        auto is_open() const -> bool { return writer.is_open(); }
+        void record(const Command &command);
+
+      private:
+        record_file::Writer<record_size> writer;
+    };
+
+    // Reads a whole stream, returns nullopt when the file is missing, not a command stream, truncated or broken
+    auto read(const std::string &path) -> std::optional<std::vector<Command>>;
+
+    // Add it to the scheduler after the GPU's clock: a command recorded at time T was sent after the GPU's clock
+    // ticked at T, and clocks that are due at the same time tick in the order they were added.
+    template <CommandInput Gpu> struct ReplayClock : ClockBase {
+        ReplayClock(Gpu *gpu, std::span<const Command> commands) : gpu(gpu), commands(commands) {
+            name = "gpu commands";
+        }
+
+        void tick() override {
+            for (; next < commands.size() && commands[next].time <= now; next++) {
+                send(*gpu, commands[next].code, commands[next].data);
+            }
+        }
+
+        void advance(uint32_t delta) override {
+            now += delta;
+            tick();
+        }
+
+        auto get_time_till_next_tick() const -> uint32_t override {
+            if (done()) {
+                return std::numeric_limits<uint32_t>::max();
+            }
+            const auto remaining = commands[next].time - now;
+            return remaining > std::numeric_limits<uint32_t>::max() ? std::numeric_limits<uint32_t>::max()
+                                                                    : static_cast<uint32_t>(remaining);
+        }
+
+        auto done() const -> bool { return next == commands.size(); }
+
+      private:
+        Gpu *gpu;
+        std::span<const Command> commands;
+        std::size_t next = 0u;
+        uint64_t now = 0u;
+    };
+}
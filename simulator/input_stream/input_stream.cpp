@@ -0,0 +1,21 @@
+#include "input_stream.hpp"
+
+void input_stream::Recorder::record(const Event &event) {
+    auto bytes = record_file::Record<record_size>{};
+    record_file::store(&bytes[0], event.time);
+    bytes[8] = static_cast<uint8_t>(event.kind);
+    record_file::store(&bytes[9], event.value);
+    writer.write(bytes);
+}
+
+auto input_stream::read(const std::string &path) -> std::optional<std::vector<Event>> {
+    return record_file::read_records<record_size>(
+        path, file_magic, [](const record_file::Record<record_size> &bytes) -> std::optional<Event> {
+            if (bytes[8] > static_cast<uint8_t>(Kind::KeyRelease)) {
+                return std::nullopt;
+            }
+            return Event{.time = record_file::load<uint64_t>(&bytes[0]),
+                         .kind = static_cast<Kind>(bytes[8]),
+                         .value = record_file::load<uint32_t>(&bytes[9])};
+        });
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "record_file.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// The simulator's interactive input with the `ClockScheduler::time` it took effect at.
+//
+// Input only changes the simulation between frames, so replaying the events in order reproduces a session bit for
+// bit: the time stamps don't drive the replay, they tell when it diverged. `Recorder` writes the events of a session
+// (SIM_INPUT_RECORD in main.cpp), `read` loads them for a headless replay (SIM_INPUT_REPLAY).
+//
+// File format: `file_magic`, then 13 bytes per event - the time (8 bytes), kind and value (4 bytes), little endian.
+
+namespace input_stream {
+    enum class Kind : uint8_t {
+        Frame = 0, // one frame was simulated
+        Key = 1,   // a key that changes the simulation was pressed, the value is its raylib `KeyboardKey`
+        Char = 2,  // a character typed in the text entry mode, the value is the codepoint
+        // every key pressed or released in the window goes to the PS/2 keyboard as well, the value is the key
+        KeyPress = 3,
+        KeyRelease = 4,
+    };
+
+    struct Event {
+        uint64_t time;
+        Kind kind;
+        uint32_t value;
+
+        auto operator==(const Event &) const -> bool = default;
+    };
+
+    constexpr static char file_magic[8] = {'I', 'N', 'P', 'U', 'T', 'S', '0', '1'};
+
+    constexpr static std::size_t record_size = 13u;
+
+    struct Recorder {
+        explicit Recorder(const std::string &path) : writer(path, file_magic) {}
+
+        auto is_open() const -> bool { return writer.is_open(); }
+        void record(const Event &event);
+
+      private:
+        record_file::Writer<record_size> writer;
+    };
+
+    // Reads a whole recording, returns nullopt when the file is missing, not an input recording, truncated or broken
+    auto read(const std::string &path) -> std::optional<std::vector<Event>>;
+}
@@ -0,0 +1,178 @@
+#include "interrupts.hpp"
+#include <algorithm>
+#include <charconv>
+#include <fmt/format.h>
+#include <fstream>
+#include <vector>
+
+namespace {
+    // Every ROM of control_unit.v has 13 address bits
+    constexpr auto rom_size = std::size_t{1} << 13u;
+
+    auto read_rom(const std::string &path) -> std::optional<std::vector<uint8_t>> {
+        auto file = std::ifstream{path, std::ios::binary};
+        auto rom = std::vector<uint8_t>(rom_size);
+        if (!file.read(reinterpret_cast<char *>(rom.data()), static_cast<std::streamsize>(rom.size()))) {
+            return std::nullopt;
+        }
+        return rom;
+    }
+
+    // Bits of the microcode ROMs as control_unit.v wires them, MCC_RST is in F, the rest in G
+    constexpr auto mcc_rst = uint8_t{1u << 2u};
+    constexpr auto int_address_out = uint8_t{1u << 2u};
+    constexpr auto rst_int(uint32_t line) -> uint8_t { return static_cast<uint8_t>(1u << (3u + line)); }
+
+    auto parse_number(std::string_view text) -> std::optional<uint64_t> {
+        auto value = uint64_t{0};
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (text.empty() || error != std::errc{} || end != text.data() + text.size()) {
+            return std::nullopt;
+        }
+        return value;
+    }
+}
+
+auto interrupts::parse_config(std::string_view config) -> std::optional<Config> {
+    auto result = Config{};
+
+    while (!config.empty()) {
+        const auto space = config.find(' ');
+        const auto item = config.substr(0, space);
+        config = space == std::string_view::npos ? std::string_view{} : config.substr(space + 1);
+        if (item.empty()) {
+            continue;
+        }
+
+        const auto equals = item.find('=');
+        if (equals == std::string_view::npos) {
+            return std::nullopt;
+        }
+        const auto name = item.substr(0, equals);
+        auto value = item.substr(equals + 1);
+
+        const auto source = std::ranges::find(source_names, name);
+        if (source == source_names.end()) {
+            return std::nullopt;
+        }
+        const auto index = static_cast<std::size_t>(source - source_names.begin());
+
+        // the timer's line is followed by its period
+        if (static_cast<Source>(index) == Source::Timer) {
+            const auto colon = value.find(':');
+            const auto cycles = colon == std::string_view::npos ? std::nullopt : parse_number(value.substr(colon + 1));
+            if (!cycles || *cycles == 0u) {
+                return std::nullopt;
+            }
+            result.timer_cycles = *cycles;
+            value = value.substr(0, colon);
+        }
+
+        const auto line = parse_number(value);
+        if (!line || *line >= line_count) {
+            return std::nullopt;
+        }
+        result.lines[index] = static_cast<uint32_t>(*line);
+    }
+
+    return result;
+}
+
+auto interrupts::check_roms(const std::string &directory, const Config &config) -> std::optional<std::string> {
+    const auto g = read_rom(directory + "/G.bin");
+    const auto f = read_rom(directory + "/F.bin");
+    const auto rom_int = read_rom(directory + "/INT.bin");
+    const auto branch = read_rom(directory + "/BRANCH.bin");
+    if (!g || !f || !rom_int || !branch) {
+        return fmt::format("can't read the microcode in {}", directory);
+    }
+
+    // `inst_reg <= rom_cjmp[{rom_int[{int_bus, data}], flags}]` and the microcode at `{inst_reg, mcc}`
+    const auto decode = [&](uint32_t int_bus, uint32_t opcode, uint32_t flags) {
+        return (*branch)[static_cast<std::size_t>((*rom_int)[int_bus << 8u | opcode]) << 5u | flags];
+    };
+    const auto step = [](uint32_t inst, uint32_t mcc) { return static_cast<std::size_t>(inst << 4u | mcc); };
+
+    for (auto line = 0u; line < line_count; line++) {
+        if (std::ranges::find(config.lines, line) == config.lines.end()) {
+            continue;
+        }
+
+        for (auto opcode = 0u; opcode < 256u; opcode++) {
+            if (((*g)[step(decode(0u, opcode, 0u), 0u)] & rst_int(line)) != 0u) {
+                return fmt::format("line {}: the microcode holds its latch reset while it fetches opcode {:02x}", line,
+                                   opcode);
+            }
+
+            for (auto flags = 0u; flags < 32u; flags++) {
+                const auto inst = decode(1u << line, opcode, flags);
+                auto reads_vector = false;
+                auto resets_latch = false;
+                for (auto mcc = 0u; mcc < 16u; mcc++) {
+                    reads_vector |= ((*g)[step(inst, mcc)] & int_address_out) != 0u;
+                    resets_latch |= ((*g)[step(inst, mcc)] & rst_int(line)) != 0u;
+                    if (((*f)[step(inst, mcc)] & mcc_rst) != 0u) {
+                        break;
+                    }
+                }
+                if (!reads_vector) {
+                    return fmt::format("line {}: enters the microcode at {:02x}, which never reads the vector at {:04x}",
+                                       line, inst, vector_of(line));
+                }
+                if (!resets_latch) {
+                    return fmt::format("line {}: enters the microcode at {:02x}, which never resets its latch", line,
+                                       inst);
+                }
+            }
+        }
+    }
+
+    return std::nullopt;
+}
+
+auto interrupts::Router::line_name(uint32_t line) const -> std::string {
+    auto name = std::string{};
+    for (auto i = 0u; i < source_count; i++) {
+        if (config.lines[i] == line) {
+            name += name.empty() ? "" : ",";
+            name += source_names[i];
+        }
+    }
+    return name;
+}
+
+auto interrupts::Router::report() const -> std::string {
+    constexpr auto bar_width = 40u;
+    auto out = std::string{};
+
+    for (auto line = 0u; line < line_count; line++) {
+        const auto &line_stats = stats[line];
+        if (line_stats.raised == 0u) {
+            continue;
+        }
+
+        const auto &latency = line_stats.latency;
+        out += fmt::format("line {} ({}) at {:04x}: {} raised, {} coalesced, {} serviced", line, line_name(line),
+                           vector_of(line), line_stats.raised, line_stats.coalesced, latency.count);
+        if (latency.count == 0u) {
+            out += '\n';
+            continue;
+        }
+        out += fmt::format(", latency min {} mean {:.1f} max {} cycles\n", latency.min, latency.mean(), latency.max);
+
+        const auto most = *std::ranges::max_element(latency.buckets);
+        const auto first = LatencyHistogram::bucket_of(latency.min);
+        const auto last = LatencyHistogram::bucket_of(latency.max);
+        for (auto bucket = first; bucket <= last; bucket++) {
+            const auto count = latency.buckets[bucket];
+            const auto start = LatencyHistogram::bucket_start(bucket);
+            const auto end = bucket + 1u < LatencyHistogram::bucket_count
+                                 ? fmt::format("{}", LatencyHistogram::bucket_start(bucket + 1u) - 1u)
+                                 : std::string{"..."};
+            out += fmt::format("  {:>7} - {:<7} {:>8} {}\n", start, end, count,
+                               std::string(static_cast<std::size_t>(count * bar_width / most), '#'));
+        }
+    }
+
+    return out;
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "clockable_module.hpp"
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Interrupt sources of the simulated system routed to the CPU's `int_in` lines.
+//
+// control_unit.v latches a rising edge of `int_in[n]` and, with interrupts enabled, runs the ISR microcode at the
+// next fetch. It reads the handler address from the vector of line n at 0xFFF2 + 2n (with INT_ADDRESS_OUT driving
+// the address bus) and jumps there, nothing is ever fetched from the vector itself. `Router` raises the line of a
+// source and holds it until the CPU fetches the first instruction after reading that vector, then records the time
+// in between as the line's latency. A source that fires again before that is counted as coalesced, the CPU only
+// sees one edge.
+//
+// SIM_INTERRUPTS configures the routes in the simulator, e.g. `vsync=0 ps2=1 timer=2:100000`: the source, the line
+// and for the timer its period in CPU cycles. `ps2` is raised for every byte the keyboard controller receives.
+//
+// The microcode in resources/roms can't take an interrupt yet: G.bin resets the INT0 latch in every step, including
+// the fetch, and INT.bin sends every latched line to the blank microcode at 0xD8 instead of the ISR, so no vector is
+// ever read. `check_roms` finds both, the simulator refuses SIM_INTERRUPTS while it reports a problem.
+
+namespace interrupts {
+    constexpr static uint32_t line_count = 5u;
+    constexpr static uint16_t first_vector = 0xFFF2u;
+
+    // The address decoder in control_unit.v, every vector is two bytes
+    constexpr auto vector_of(uint32_t line) -> uint16_t { return static_cast<uint16_t>(first_vector + 2u * line); }
+
+    constexpr auto line_of_vector(uint16_t address) -> std::optional<uint32_t> {
+        if (address < first_vector || address >= vector_of(line_count)) {
+            return std::nullopt;
+        }
+        return (address - first_vector) / 2u;
+    }
+
+    enum class Source : uint8_t { Vsync, Ps2Byte, Timer };
+    constexpr static std::size_t source_count = 3u;
+    constexpr static std::array<const char *, source_count> source_names = {"vsync", "ps2", "timer"};
+
+    struct Config {
+        std::array<std::optional<uint32_t>, source_count> lines{};
+        // 0 stops the timer
+        uint64_t timer_cycles = 0u;
+    };
+
+    auto parse_config(std::string_view config) -> std::optional<Config>;
+
+    // Checks that the microcode in `directory` (G.bin, F.bin, INT.bin and BRANCH.bin) takes an interrupt on every line
+    // routed by `config`: the fetch leaves the line's latch alone and the microcode it enters reads the line's vector
+    // and resets its latch before the next fetch. Returns the first problem found.
+    auto check_roms(const std::string &directory, const Config &config) -> std::optional<std::string>;
+
+    // Latencies in CPU cycles, bucket 0 holds 0 and bucket i > 0 holds [2^(i-1), 2^i), the last one everything above
+    struct LatencyHistogram {
+        constexpr static std::size_t bucket_count = 20u;
+
+        std::array<uint64_t, bucket_count> buckets{};
+        uint64_t count = 0u;
+        uint64_t min = std::numeric_limits<uint64_t>::max();
+        uint64_t max = 0u;
+        uint64_t sum = 0u;
+
+        constexpr static auto bucket_of(uint64_t cycles) -> std::size_t {
+            const auto bucket = static_cast<std::size_t>(std::bit_width(cycles));
+            return bucket < bucket_count ? bucket : bucket_count - 1u;
+        }
+
+        // Smallest latency of a bucket
+        constexpr static auto bucket_start(std::size_t bucket) -> uint64_t {
+            return bucket == 0u ? 0u : uint64_t{1} << (bucket - 1u);
+        }
+
+        void add(uint64_t cycles) {
+            buckets[bucket_of(cycles)]++;
+            count++;
+            min = cycles < min ? cycles : min;
+            max = cycles > max ? cycles : max;
+            sum += cycles;
+        }
+
+        auto mean() const -> double { return count == 0u ? 0.0 : static_cast<double>(sum) / static_cast<double>(count); }
+    };
+
+    struct LineStats {
+        uint64_t raised = 0u;
+        uint64_t coalesced = 0u;
+        LatencyHistogram latency{};
+    };
+
+    struct Router {
+        // `cycle_period` is the CPU clock's period in scheduler time units, latencies are counted in CPU cycles
+        Router(Config config, uint32_t cycle_period) : config(config), cycle_period(cycle_period) {}
+
+        void raise(Source source, uint64_t time) {
+            const auto line = config.lines[static_cast<std::size_t>(source)];
+            if (!line) {
+                return;
+            }
+
+            auto &line_stats = stats[*line];
+            line_stats.raised++;
+            const auto bit = static_cast<uint8_t>(1u << *line);
+            if ((pending & bit) != 0u) {
+                line_stats.coalesced++;
+                return;
+            }
+            pending |= bit;
+            raised_at[*line] = time;
+        }
+
+        // The ISR microcode put `address` on the address bus with INT_ADDRESS_OUT, the vector of the line it enters
+        void vector_read(uint16_t address) {
+            const auto line = line_of_vector(address);
+            entering = line && address == vector_of(*line) ? line : std::nullopt;
+        }
+
+        // Every instruction fetch, the first one after a vector read is the handler's and acknowledges the line
+        void fetched(uint64_t time) {
+            if (!entering) {
+                return;
+            }
+            const auto line = *entering;
+            entering.reset();
+            if ((pending & 1u << line) == 0u) {
+                return;
+            }
+            pending &= static_cast<uint8_t>(~(1u << line));
+            stats[line].latency.add((time - raised_at[line]) / cycle_period);
+        }
+
+        // For `int_in`
+        auto lines() const -> uint8_t { return pending; }
+
+        // The sources routed to `line`, separated by commas
+        auto line_name(uint32_t line) const -> std::string;
+        // A text histogram of every line that was raised
+        auto report() const -> std::string;
+
+        Config config;
+        uint32_t cycle_period;
+        std::array<LineStats, line_count> stats{};
+
+      private:
+        uint8_t pending = 0u;
+        std::optional<uint32_t> entering{};
+        std::array<uint64_t, line_count> raised_at{};
+    };
+
+    // Drives `int_in` of Vcpu (or Vcpu_mux) and watches its vector reads and instruction fetches, call it after every
+    // eval of the CPU. The caller has to include the CPU's `___024root.h`.
+    template <typename Cpu> struct CpuPort {
+        // REG_IR_LOAD and INT_ADDRESS_OUT in cpu/include/signals.v
+        constexpr static auto ir_load_bit = 39u;
+        constexpr static auto int_address_out_bit = 47u;
+
+        explicit CpuPort(Router *router) : router(router) {}
+
+        void update(Cpu &cpu, uint64_t time) {
+            const auto signals = cpu.rootp->cpu_adapter__DOT__cpu__DOT__signals;
+            if (((signals >> int_address_out_bit) & 1u) != 0u) {
+                router->vector_read(cpu.addr_bus);
+            }
+            // the first eval with REG_IR_LOAD is the fetch
+            const auto ir_load = ((signals >> ir_load_bit) & 1u) != 0u;
+            if (ir_load && !last_ir_load) {
+                router->fetched(time);
+            }
+            last_ir_load = ir_load;
+            cpu.int_in = router->lines();
+        }
+
+        Router *router;
+
+      private:
+        bool last_ir_load = false;
+    };
+
+    // The programmable timer source, raises `Source::Timer` every `period` scheduler time units
+    struct Timer : ClockBase {
+        Timer(Router *router, const ClockScheduler *scheduler, uint32_t period)
+            : router(router), scheduler(scheduler), period(period) {
+            name = "timer";
+        }
+
+        void tick() override {
+            time_since_last_tick = 0u;
+            PROFILE_COUNT(posedges);
+            router->raise(Source::Timer, scheduler->time);
+        }
+
+        void advance(uint32_t delta) override {
+            if (period == 0u) {
+                return;
+            }
+            time_since_last_tick += delta;
+            if (time_since_last_tick >= period) {
+                tick();
+            }
+        }
+
+        auto get_time_till_next_tick() const -> uint32_t override {
+            return period == 0u ? std::numeric_limits<uint32_t>::max() : period - time_since_last_tick;
+        }
+
+        // 0 stops the timer, a new period starts counting now
+        void set_period(uint32_t new_period) {
+            period = new_period;
+            time_since_last_tick = 0u;
+        }
+
+      private:
+        Router *router;
+        const ClockScheduler *scheduler;
+        uint32_t period;
+        uint32_t time_since_last_tick = 0u;
+    };
+}
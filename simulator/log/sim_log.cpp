@@ -0,0 +1,68 @@
+#include "sim_log.hpp"
+#include "record_file.hpp"
+#include "ring_buffer.hpp"
+#include <atomic>
+
+namespace {
+    constexpr static std::size_t buffer_capacity = 1u << 16;
+
+    std::atomic<uint32_t> enabled_mask{0u};
+    std::atomic<uint64_t> dropped_records{0u};
+    const uint64_t *time_source = nullptr;
+    RingBuffer<sim_log::Record, buffer_capacity> records{};
+}
+
+void sim_log::set_mask(uint32_t mask) { enabled_mask.store(mask & all_sources, std::memory_order_relaxed); }
+
+auto sim_log::get_mask() -> uint32_t { return enabled_mask.load(std::memory_order_relaxed); }
+
+void sim_log::enable(Source source) { enabled_mask.fetch_or(mask_of(source), std::memory_order_relaxed); }
+
+void sim_log::disable(Source source) { enabled_mask.fetch_and(~mask_of(source), std::memory_order_relaxed); }
+
+void sim_log::set_time_source(const uint64_t *time) { time_source = time; }
+
+auto sim_log::dropped() -> uint64_t { return dropped_records.load(std::memory_order_relaxed); }
+
+auto sim_log::drain(std::FILE *file) -> std::size_t {
+    return records.drain([file](const Record &record) { std::fwrite(&record, sizeof(Record), 1, file); });
+}
+
+void sim_log::discard() {
+    records.drain([](const Record &) {});
+}
+
+sim_log::FileSink::FileSink(const char *path) : file(record_file::create(path, file_magic)) {}
+
+sim_log::FileSink::~FileSink() {
+    if (file != nullptr) {
+        flush();
+        std::fclose(file);
+    }
+}
+
+auto sim_log::FileSink::flush() -> std::size_t {
+    if (file == nullptr) {
+        return 0u;
+    }
+    return drain(file);
+}
+
+extern "C" void sim_log_event(int source, long long timestamp, int a, int b) {
+    const auto bit = 1u << static_cast<uint32_t>(source);
+    if ((enabled_mask.load(std::memory_order_relaxed) & bit) == 0u) {
+        return;
+    }
+
+    const auto record = sim_log::Record{
+        .timestamp = time_source != nullptr ? *time_source : static_cast<uint64_t>(timestamp),
+        .a = static_cast<uint32_t>(a),
+        .b = static_cast<uint16_t>(b),
+        .source = static_cast<uint8_t>(source),
+        .reserved = 0u,
+    };
+
+    if (!records.push(record)) {
+        dropped_records.fetch_add(1u, std::memory_order_relaxed);
+    }
+}
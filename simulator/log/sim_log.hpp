@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+// Binary logging channel for the verilated modules.
+//
+// The RTL calls `sim_log_event` (imported through DPI-C, see `cpu/include/sim_log.v`) instead of `$display`,
+// the event is packed into a fixed size record and pushed into a lock-free ring buffer. Nothing is
+// formatted on the simulation thread - records are drained to a file and turned into text offline
+// with `tools/sim_log_format.py`.
+
+namespace sim_log {
+    // Must match the `LOG_SRC_*` defines in `cpu/include/sim_log.v`
+    enum class Source : uint8_t {
+        IrLoad = 0,        // control unit: a = data bus
+        RamWrite = 1,      // ram: a = address, b = data
+        MarLoad = 2,       // mem unit: a = address
+        MbrLoad = 3,       // mem unit: a = data
+        GpuRamWrite = 4,   // gpu char/color buffer: a = address, b = data
+        GpuCursorMove = 5, // gpu: a = write cursor
+        Count
+    };
+
+    struct Record {
+        uint64_t timestamp;
+        uint32_t a;
+        uint16_t b;
+        uint8_t source;
+        uint8_t reserved;
+    };
+    static_assert(sizeof(Record) == 16);
+
+    // File layout: `file_magic` followed by a stream of `Record`s (native endianness)
+    constexpr static char file_magic[8] = {'S', 'I', 'M', 'L', 'O', 'G', '0', '1'};
+
+    constexpr auto mask_of(Source source) -> uint32_t { return 1u << static_cast<uint32_t>(source); }
+    constexpr static uint32_t all_sources = (1u << static_cast<uint32_t>(Source::Count)) - 1u;
+
+    // Every source is disabled by default, a disabled source costs a single mask test
+    void set_mask(uint32_t mask);
+    auto get_mask() -> uint32_t;
+    void enable(Source source);
+    void disable(Source source);
+
+    // Records are stamped with `*time` instead of the RTL's `$time`, which only advances when the harness moves the
+    // VerilatedContext's time. Point it at `ClockScheduler::time`, nullptr goes back to `$time`.
+    void set_time_source(const uint64_t *time);
+
+    // Number of records lost because the ring buffer was full
+    auto dropped() -> uint64_t;
+
+    // Consumer side, must be called from one thread at a time
+    auto drain(std::FILE *file) -> std::size_t;
+    void discard();
+
+    struct FileSink {
+        explicit FileSink(const char *path);
+        ~FileSink();
+
+        FileSink(const FileSink &) = delete;
+        auto operator=(const FileSink &) -> FileSink & = delete;
+
+        auto is_open() const -> bool { return file != nullptr; }
+        auto flush() -> std::size_t;
+
+      private:
+        std::FILE *file;
+    };
+}
+
+extern "C" void sim_log_event(int source, long long timestamp, int a, int b);
@@ -1,20 +1,41 @@
 #include "clockable_module.hpp"
+#include "frame_hash.hpp"
+#include "performance_hud.hpp"
 #include "vga_simulator.hpp"
 #include <Vcpu___024root.h>
 #include <Vmem_unit.h>
 #include <Vmonitor_tester.h>
 #include <Vgpu.h>
+#include <Vgpu___024root.h>
 #include <Vcpu.h>
 #include <imgui.h>
 #include <raylib.h>
 #include <rlImGui.h>
 #include <fmt/color.h>
 #include <fmt/base.h>
+#include <chrono>
 #include <span>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include <limits>
 #include <ps2.hpp>
+#include <ps2_line.hpp>
+#include <sim_log.hpp>
+#include <trace.hpp>
+#include <trigger.hpp>
+#include <gpu_stream.hpp>
+#include <interrupts.hpp>
+#include <input_stream.hpp>
+#include <gpu_command_port.hpp>
+#include <video_capture.hpp>
 
 // Raylib / Display constants
 constexpr static uint32_t scale = 2u;
+// the GPU's clock, a period of 1 in the clock scheduler
+constexpr static uint64_t pixel_clock_hz = 25'175'000u;
 constexpr static auto scaled_width = static_cast<uint32_t>(h_visible_area * scale);
 constexpr static auto scaled_height = static_cast<uint32_t>(v_visible_area * scale);
 
@@ -53,9 +74,39 @@ void print_cpu(const Vcpu& cpu) {
     fmt::println("CPU: PC: {} | A: {} | B: {}", pc_out, a_out, b_out);
 }
 
+// SIM_INTERRUPTS: the interrupt sources polled at every CPU eval and the CPU's side of the router
+struct InterruptSources {
+    interrupts::Router *router;
+    interrupts::CpuPort<Vcpu> port;
+    const Vgpu *gpu;
+    const ClockScheduler *scheduler;
+    ps2::Receiver *keyboard_controller;
+    bool last_vsync = false;
+
+    void update(Vcpu &cpu) {
+        const auto time = scheduler->time;
+        // gpu.sv drives vsync active high
+        const bool vsync = gpu->vsync != 0;
+        if (vsync && !last_vsync) {
+            router->raise(interrupts::Source::Vsync, time);
+        }
+        last_vsync = vsync;
+        // the CPU has no port to the controller's data register, the byte is read as it arrives so the next one
+        // raises `interrupt` again
+        if (keyboard_controller->interrupt) {
+            keyboard_controller->read();
+            router->raise(interrupts::Source::Ps2Byte, time);
+        }
+        port.update(cpu, time);
+    }
+};
+
 struct CpuAndMem {
     Vcpu* cpu;
     Vmem_unit* mem;
+    trace::CpuRecorder* recorder = nullptr;
+    trace::TriggeredRecorder* triggered_recorder = nullptr;
+    InterruptSources* interrupt_sources = nullptr;
 
     CData* clk() {
         return &cpu->clk;
@@ -64,13 +115,31 @@ struct CpuAndMem {
     void eval() {
         cpu->eval();
         mem->eval();
+        if (recorder) {
+            recorder->capture(*cpu);
+        }
+        if (triggered_recorder) {
+            triggered_recorder->capture(*cpu);
+        }
+        if (interrupt_sources) {
+            interrupt_sources->update(*cpu);
+        }
     }
 };
 
 auto main() -> int {
     auto pixels = std::array<Color, scaled_width * scaled_height>{};
 
-    auto ps2 = ps2::Keyboard{};
+    // SIM_LOG_MASK selects the RTL log sources (see sim_log::Source) recorded into sim_log.bin,
+    // use tools/sim_log_format.py to read it
+    auto log_sink = std::optional<sim_log::FileSink>{};
+    if (const auto *log_mask = std::getenv("SIM_LOG_MASK")) {
+        sim_log::set_mask(static_cast<uint32_t>(std::strtoul(log_mask, nullptr, 0)));
+        log_sink.emplace("sim_log.bin");
+    }
+
+    auto keyboard = ps2::Keyboard{};
+    auto keyboard_controller = ps2::Receiver{};
 
     Vmonitor_tester monitor_tester{};
     Vgpu gpu{};
@@ -80,17 +149,313 @@ auto main() -> int {
     CpuAndMem cpu_and_mem{&cpu, &cpu_memory};
 
     auto cpu_clock = Clock{&cpu_and_mem, 4, 0, true};
-    auto gpu_clock = Clock{&gpu, 1, 0, true};
+    // every command for the GPU goes through the port, it is sent at the GPU's clock edges
+    auto gpu_port = GpuCommandPort{&gpu};
+    auto gpu_clock = Clock{&gpu_port, 1, 0, true};
+    cpu_clock.name = "cpu";
+    gpu_clock.name = "gpu";
 
     auto clock_scheduler = ClockScheduler{};
     clock_scheduler.add_clock(&gpu_clock);
     clock_scheduler.add_clock(&cpu_clock);
+    // the keyboard's lines are only scheduled while a key event is sent, see simulate_frame
+    auto ps2_driver = ps2::LineDriver{&keyboard, &keyboard_controller, ps2::clock_half_period(pixel_clock_hz)};
+    // log records are stamped in scheduler time, the units of the clock periods
+    sim_log::set_time_source(&clock_scheduler.time);
 
     gpu.rst = 0;
     VGASimulator simulator(&gpu, &clock_scheduler);
 
+    // SIM_PERF enables hardware performance counters (Linux only), results per simulated frame go to perf_frames.csv
+    auto cpu_perf = perf::CounterGroup{"cpu"};
+    auto gpu_perf = perf::CounterGroup{"gpu"};
+    auto vga_perf = perf::CounterGroup{"vga capture"};
+    auto perf_report = std::optional<perf::FrameReport>{};
+    if (std::getenv("SIM_PERF") != nullptr) {
+        if (cpu_perf.open() && gpu_perf.open() && vga_perf.open()) {
+            cpu_clock.perf_group = &cpu_perf;
+            gpu_clock.perf_group = &gpu_perf;
+            simulator.perf_group = &vga_perf;
+
+            perf_report.emplace("perf_frames.csv");
+            perf_report->add_group(&cpu_perf);
+            perf_report->add_group(&gpu_perf);
+            perf_report->add_group(&vga_perf);
+        } else {
+            fmt::println("perf_event_open failed, hardware counters are disabled");
+        }
+    }
+
+    // SIM_TRACE keeps the last SIM_TRACE cycles of the CPU in memory, F3 (or an abort) writes them to trace.fst
+    auto cpu_trace = std::optional<trace::CpuRecorder>{};
+    if (const auto *trace_cycles = std::getenv("SIM_TRACE")) {
+        cpu_trace.emplace("cpu", std::strtoul(trace_cycles, nullptr, 0));
+        cpu_and_mem.recorder = &*cpu_trace;
+        trace::dump_on_abort(&*cpu_trace, "trace.fst");
+    }
+
+    // SIM_TRACE_TRIGGER captures only around trigger conditions into trace_<n>.fst, see trace/trigger.hpp
+    auto triggered_trace = std::optional<trace::TriggeredRecorder>{};
+    if (const auto *trigger = std::getenv("SIM_TRACE_TRIGGER")) {
+        if (const auto config = trace::parse_trigger_config(trigger)) {
+            triggered_trace.emplace("cpu", *config, "trace");
+            cpu_and_mem.triggered_recorder = &*triggered_trace;
+        } else {
+            fmt::println("invalid SIM_TRACE_TRIGGER: {}", trigger);
+        }
+    }
+
+    // SIM_GPU_RECORD writes every command sent to the GPU to the given file, replay it with bench/gpu_replay
+    auto gpu_recorder = std::optional<gpu_stream::Recorder>{};
+    if (const auto *gpu_record_path = std::getenv("SIM_GPU_RECORD")) {
+        gpu_recorder.emplace(gpu_record_path);
+        if (!gpu_recorder->is_open()) {
+            fmt::println("failed to open {}", gpu_record_path);
+            gpu_recorder.reset();
+        } else {
+            gpu_port.recorder = &*gpu_recorder;
+            gpu_port.scheduler = &clock_scheduler;
+        }
+    }
+
+    // SIM_INTERRUPTS routes interrupt sources to the CPU's int_in lines, e.g. `vsync=0 timer=2:100000` (see
+    // interrupts.hpp), the latency histograms are shown in the performance HUD and printed at the end
+    auto interrupt_router = std::optional<interrupts::Router>{};
+    auto interrupt_sources = std::optional<InterruptSources>{};
+    auto interrupt_timer = std::optional<interrupts::Timer>{};
+    if (const auto *interrupt_config = std::getenv("SIM_INTERRUPTS")) {
+        const auto config = interrupts::parse_config(interrupt_config);
+        const auto rom_problem = config ? interrupts::check_roms(ROMS_DIR, *config) : std::nullopt;
+        if (!config) {
+            fmt::println("invalid SIM_INTERRUPTS: {}", interrupt_config);
+        } else if (rom_problem) {
+            fmt::println("SIM_INTERRUPTS ignored, the microcode can't take these interrupts: {}", *rom_problem);
+        } else {
+            const auto cycle_period = cpu_clock.pos_period + cpu_clock.neg_period;
+            interrupt_router.emplace(*config, cycle_period);
+            interrupt_sources.emplace(InterruptSources{.router = &*interrupt_router,
+                                                       .port = interrupts::CpuPort<Vcpu>{&*interrupt_router},
+                                                       .gpu = &gpu,
+                                                       .scheduler = &clock_scheduler,
+                                                       .keyboard_controller = &keyboard_controller});
+            cpu_and_mem.interrupt_sources = &*interrupt_sources;
+
+            if (config->timer_cycles > 0u) {
+                const auto period = std::min<uint64_t>(config->timer_cycles * cycle_period,
+                                                       std::numeric_limits<uint32_t>::max());
+                interrupt_timer.emplace(&*interrupt_router, &clock_scheduler, static_cast<uint32_t>(period));
+                clock_scheduler.add_clock(&*interrupt_timer);
+            }
+        }
+    }
+
+    // SIM_VIDEO records every simulated frame to the given file (tools/video_to_y4m.py converts it), frames are
+    // dropped instead of slowing the simulation down when SIM_VIDEO_DROP is set as well
+    auto video = std::optional<video_capture::Writer>{};
+    if (const auto *video_path = std::getenv("SIM_VIDEO")) {
+        const auto policy =
+            std::getenv("SIM_VIDEO_DROP") != nullptr ? video_capture::Policy::Drop : video_capture::Policy::Wait;
+        video.emplace(video_path, static_cast<uint16_t>(h_visible_area), static_cast<uint16_t>(v_visible_area), policy);
+        if (!video->is_open()) {
+            fmt::println("failed to open {}", video_path);
+            video.reset();
+        }
+    }
+
+    // SIM_SYNC_CHECK selects the frames whose sync timing is checked: all (default), first or every Nth frame
+    if (const auto *sync_check = std::getenv("SIM_SYNC_CHECK")) {
+        if (const auto validation = parse_sync_validation(sync_check)) {
+            simulator.sync_checker.validation = *validation;
+        } else {
+            fmt::println("invalid SIM_SYNC_CHECK: {}", sync_check);
+        }
+    }
+
+    // SIM_INPUT_RECORD writes the input of the session to the given file, SIM_INPUT_REPLAY reruns such a session
+    // without a window as fast as possible. Both print a hash of every drawn frame at the end to compare the runs.
+    auto input_recorder = std::optional<input_stream::Recorder>{};
+    if (const auto *input_record_path = std::getenv("SIM_INPUT_RECORD")) {
+        input_recorder.emplace(input_record_path);
+        if (!input_recorder->is_open()) {
+            fmt::println("failed to open {}", input_record_path);
+            input_recorder.reset();
+        }
+    }
+    auto replay = std::optional<std::vector<input_stream::Event>>{};
+    if (const auto *input_replay_path = std::getenv("SIM_INPUT_REPLAY")) {
+        replay = input_stream::read(input_replay_path);
+        if (!replay) {
+            fmt::println("{} is not an input recording", input_replay_path);
+            return 1;
+        }
+    }
+    const bool headless = replay.has_value();
+    auto run_hash = input_recorder || replay ? std::optional<FrameHash>{FrameHash{}} : std::nullopt;
+    auto frames = uint64_t{0};
+
     simulator.sync();
 
+    bool wait_for_key = false;
+    auto scroll_row = 0u;
+    // With double buffering the screen only changes on a page flip or a scroll, the frames in between are simulated
+    // without drawing
+    auto shown_state = std::optional<std::pair<bool, uint32_t>>{};
+    bool texture_stale = false;
+
+    const auto simulate_frame = [&] {
+        // picks up the key events queued since the last frame, an event takes about a millisecond to send
+        ps2_driver.schedule(clock_scheduler);
+        // the GPU's own scroll register, the guest scrolls through the command port as well
+        const auto frame_state = std::pair{gpu.display_page != 0, uint32_t{gpu.rootp->gpu__DOT__scroll_row}};
+        const bool double_buffered = gpu.double_buffered;
+        const bool damaged = !double_buffered || shown_state != frame_state;
+
+        // an unchanged frame is recorded as a repeat of the previous one
+        auto *video_frame = video && damaged ? video->begin_frame() : nullptr;
+        auto *hash = run_hash ? &*run_hash : nullptr;
+
+        const auto draw = [&pixels, video_frame, hash, headless](const uint32_t x, const uint32_t y, const Color color) {
+            if (!headless) {
+                set_pixel_scaled(pixels, x, y, color);
+            }
+            if (video_frame) {
+                video_frame[y * h_visible_area + x] = video_capture::pack(color.r, color.g, color.b);
+            }
+            if (hash) {
+                hash->add(color);
+            }
+        };
+
+        auto is_timing_correct = damaged
+            ? simulator.process_vga_frame(draw)
+            : simulator.process_vga_frame([](const uint32_t, const uint32_t, const Color) {});
+        print_error_if_failed(is_timing_correct);
+        if (video) {
+            if (damaged) {
+                video->end_frame();
+            } else {
+                video->repeat_frame();
+            }
+        }
+        if (perf_report) {
+            perf_report->end_frame();
+        }
+        if (!headless) {
+            print_cpu(cpu);
+        }
+        frames++;
+
+        // the front page is only written while single buffered
+        shown_state = double_buffered && gpu.double_buffered ? std::optional{frame_state} : std::nullopt;
+        texture_stale = texture_stale || damaged;
+    };
+
+    // Everything the input changes in the simulation goes through here, live or replayed
+    const auto apply_input = [&](const input_stream::Event &event) {
+        switch (event.kind) {
+            case input_stream::Kind::Frame:
+                simulate_frame();
+                break;
+            case input_stream::Kind::Char:
+                gpu_port.store_byte(static_cast<uint8_t>(event.value));
+                wait_for_key = false;
+                break;
+            case input_stream::Kind::KeyPress:
+            case input_stream::Kind::KeyRelease:
+                keyboard.send_key(static_cast<KeyboardKey>(event.value),
+                                  event.kind == input_stream::Kind::KeyRelease);
+                break;
+            case input_stream::Kind::Key:
+                switch (static_cast<KeyboardKey>(event.value)) {
+                    case KEY_I:
+                        wait_for_key = true;
+                        // TODO: color support
+                        break;
+                    case KEY_F4:
+                        gpu_port.double_buffer(!gpu.double_buffered);
+                        break;
+                    case KEY_F5:
+                        gpu_port.flip();
+                        break;
+                    case KEY_DELETE:
+                        gpu_port.clear();
+                        break;
+                    case KEY_PAGE_DOWN:
+                    case KEY_PAGE_UP:
+                        scroll_row = (scroll_row + (event.value == KEY_PAGE_DOWN ? 1u : 59u)) % 60u;
+                        gpu_port.scroll_to(static_cast<uint8_t>(scroll_row));
+                        break;
+                    case KEY_RIGHT:
+                        gpu_port.move_cursor_columns(1);
+                        break;
+                    case KEY_LEFT:
+                        gpu_port.move_cursor_columns(-1);
+                        break;
+                    case KEY_UP:
+                        gpu_port.move_cursor_rows(-1);
+                        break;
+                    case KEY_DOWN:
+                        gpu_port.move_cursor_rows(1);
+                        break;
+                    default:
+                        break;
+                }
+                break;
+        }
+    };
+
+    const auto input = [&](input_stream::Kind kind, uint32_t value) {
+        const auto event = input_stream::Event{.time = clock_scheduler.time, .kind = kind, .value = value};
+        if (input_recorder) {
+            input_recorder->record(event);
+        }
+        apply_input(event);
+    };
+
+    const auto print_summary = [&] {
+        if (run_hash) {
+            fmt::println("input: {} frames, frame hash {:016x}", frames, run_hash->value);
+        }
+
+        if (video) {
+            fmt::println("video: {} frames, {} dropped", video->frames(), video->dropped());
+        }
+
+        if (interrupt_router) {
+            fmt::print("interrupts:\n{}", interrupt_router->report());
+        }
+
+        const auto &violations = simulator.sync_checker.result();
+        fmt::println("sync timing: {} frames checked, {} skipped, {} violations", violations.frames_checked,
+                     violations.frames_skipped, violations.total());
+        if (violations.first) {
+            fmt::print("first in frame {}, ", violations.first_frame);
+            print_vga_error(*violations.first);
+        }
+    };
+
+    if (headless) {
+        const auto start = std::chrono::steady_clock::now();
+        for (auto i = std::size_t{0}; i < replay->size(); i++) {
+            const auto &event = (*replay)[i];
+            // the same input at a different time means the simulation isn't the recorded one anymore
+            if (event.time != clock_scheduler.time) {
+                fmt::println("replay diverged at event {}: recorded at {}, simulated at {}", i, event.time,
+                             clock_scheduler.time);
+                return 1;
+            }
+            apply_input(event);
+            if (log_sink) {
+                log_sink->flush();
+            }
+        }
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        fmt::println("replayed {} events in {:.3f} s, {:.2f} frames/s", replay->size(), seconds,
+                     static_cast<double>(frames) / seconds);
+        print_summary();
+        return 0;
+    }
+
     InitWindow(scaled_width, scaled_height, "VGA tester");
 
     const Image image = {.data = pixels.data(),
@@ -103,87 +468,97 @@ auto main() -> int {
 
     rlImGuiSetup(true);
 
-    bool wait_for_key = false;
+    auto performance_hud = PerformanceHud{&clock_scheduler};
+    performance_hud.interrupt_router = interrupt_router ? &*interrupt_router : nullptr;
+    bool show_performance_hud = profiler::enabled;
+
     while (!WindowShouldClose()) {
         if (IsKeyDown(KEY_SPACE)) {
+            input(input_stream::Kind::Frame, 0u);
+        }
 
-            auto is_timing_correct = simulator.process_vga_frame([&pixels](const uint32_t x, const uint32_t y, const Color color) {
-                    set_pixel_scaled(pixels,x,y,color);
-            });
-            print_error_if_failed(is_timing_correct);
-            print_cpu(cpu);
-
+        if (texture_stale) {
+            PROFILE_SCOPE(profiler::zones.texture_upload);
             UpdateTexture(texture, pixels.data());
+            texture_stale = false;
+        }
+
+        if (IsKeyPressed(KEY_F1)) {
+            show_performance_hud = !show_performance_hud;
+        }
+
+        if (IsKeyPressed(KEY_F2)) {
+            if (performance_hud.write_json("profile.json")) {
+                fmt::println("Profile written to profile.json");
+            }
+        }
+
+        if (IsKeyPressed(KEY_F3) && cpu_trace) {
+            if (trace::write_fst("trace.fst", *cpu_trace)) {
+                fmt::println("CPU trace written to trace.fst");
+            }
         }
 
         if (IsKeyPressed(KEY_I)) {
             GetCharPressed(); // extract 'i' from the queue
-            wait_for_key = true;
-            // TODO: color support
+            input(input_stream::Kind::Key, KEY_I);
         }
 
-        if (IsKeyPressed(KEY_RIGHT)) {
-            gpu.interrupt_enable = 1;
-            gpu.interrupt_code_in = 0b01;
-            gpu.interrupt_data_in = 0x81;
-            gpu.eval();
-            gpu.interrupt_enable = 0;
-            gpu.eval();
+        for (const auto key : {KEY_F4, KEY_F5, KEY_DELETE}) {
+            if (IsKeyPressed(key)) {
+                input(input_stream::Kind::Key, key);
+            }
         }
 
-        if (IsKeyPressed(KEY_LEFT)) {
-            gpu.interrupt_enable = 1;
-            gpu.interrupt_code_in = 0b01;
-            gpu.interrupt_data_in = 0xFF;
-            gpu.eval();
-            gpu.interrupt_enable = 0;
-            gpu.eval();
+        if (IsKeyPressed(KEY_PAGE_DOWN)) {
+            input(input_stream::Kind::Key, KEY_PAGE_DOWN);
+        } else if (IsKeyPressed(KEY_PAGE_UP)) {
+            input(input_stream::Kind::Key, KEY_PAGE_UP);
         }
 
-        if (IsKeyPressed(KEY_UP)) {
-            gpu.interrupt_enable = 1;
-            gpu.interrupt_code_in = 0b01;
-            gpu.interrupt_data_in = 0x7F;
-            gpu.eval();
-            gpu.interrupt_enable = 0;
-            gpu.eval();
+        for (const auto key : {KEY_RIGHT, KEY_LEFT, KEY_UP, KEY_DOWN}) {
+            if (IsKeyPressed(key)) {
+                input(input_stream::Kind::Key, key);
+            }
         }
 
-        if (IsKeyPressed(KEY_DOWN)) {
-            gpu.interrupt_enable = 1;
-            gpu.interrupt_code_in = 0b01;
-            gpu.interrupt_data_in = 0x01;
-            gpu.eval();
-            gpu.interrupt_enable = 0;
-            gpu.eval();
+        // every key goes to the PS/2 keyboard as well
+        for (auto key = GetKeyPressed(); key != 0; key = GetKeyPressed()) {
+            input(input_stream::Kind::KeyPress, static_cast<uint32_t>(key));
+        }
+        for (auto key = 0u; key < ps2::key_count; key++) {
+            if (IsKeyReleased(static_cast<int>(key))) {
+                input(input_stream::Kind::KeyRelease, key);
+            }
         }
 
         if (wait_for_key) {
-            char c;
-            if ((c = (char)GetCharPressed())) {
-                gpu.interrupt_enable = 1;
-                gpu.interrupt_code_in = 0b00;
-                gpu.interrupt_data_in = c;
-                gpu.eval();
-                gpu.interrupt_enable = 0;
-                gpu.eval();
-                wait_for_key = false;
+            if (const auto c = GetCharPressed()) {
+                input(input_stream::Kind::Char, static_cast<uint32_t>(c));
             }
         }
 
+        if (log_sink) {
+            log_sink->flush();
+        }
+
         BeginDrawing();
 
         DrawTexture(texture, 0, 0, RAYWHITE);
 
-        /*rlImGuiBegin();*/
-        /*ImGui::Begin("Hello, world!");*/
-        /*ImGui::End();*/
-        /*rlImGuiEnd();*/
+        if (show_performance_hud) {
+            rlImGuiBegin();
+            performance_hud.draw();
+            rlImGuiEnd();
+        }
 
         // DrawFPS(10, 10);
 
         EndDrawing();
 
+        performance_hud.end_frame();
     }
+
+    print_summary();
     return 0;
 }
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+// Address decoder for a small window of memory mapped registers.
+//
+// The registers of the window are a table indexed by the offset into it, so an access outside the window costs one
+// compare and one inside it an indexed call. The handlers get the device the decoder belongs to, e.g. the machine in
+// bench/guest_machine.hpp, and run at the edge that starts the memory access - a register access takes exactly as
+// many cycles as a memory access.
+
+namespace mmio {
+    template <typename Device, std::size_t Size> struct Decoder {
+        using Read = auto (*)(Device &device) -> uint8_t;
+        using Write = void (*)(Device &device, uint8_t value);
+
+        // A missing handler leaves the access to the memory behind the window
+        struct Register {
+            Read read = nullptr;
+            Write write = nullptr;
+        };
+
+        explicit Decoder(uint16_t base) : base(base) {}
+
+        void map(uint16_t address, Register handlers) {
+            assert(contains(address));
+            registers[static_cast<uint16_t>(address - base)] = handlers;
+        }
+
+        auto contains(uint16_t address) const -> bool { return static_cast<uint16_t>(address - base) < Size; }
+
+        // nullptr outside the window
+        auto find(uint16_t address) const -> const Register * {
+            const auto offset = static_cast<uint16_t>(address - base);
+            return offset < Size ? &registers[offset] : nullptr;
+        }
+
+        // An access with MAR and the memory select lines of mem_unit, whose address is {mem_part, MAR high byte &
+        // zero_page, MAR low byte}. The window is in the first memory part, stack accesses (`mem_part`) never reach
+        // it and zero page accesses (`zero_page` low) only when it starts in page 0.
+        auto find(uint16_t mar, bool mem_part, bool zero_page) const -> const Register * {
+            if (mem_part) {
+                return nullptr;
+            }
+            return find(zero_page ? mar : static_cast<uint16_t>(mar & 0x00FFu));
+        }
+
+        uint16_t base;
+
+      private:
+        std::array<Register, Size> registers{};
+    };
+}
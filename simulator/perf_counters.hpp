@@ -0,0 +1,246 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <fmt/format.h>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Optional hardware performance counters (Linux only, via perf_event_open).
+//
+// Every clock domain and the VGA capture path get their own counter group. Only one group
+// counts at a time: entering a scope pauses the group of the enclosing scope, so the capture
+// path is reported without the evals it triggers. Switching groups costs two ioctls, which is
+// why this is a separate opt-in mode and not part of the always-available profiler.
+
+namespace perf {
+    enum class Event : uint8_t { Cycles, Instructions, L1dMisses, LlcMisses, BranchMisses, Count };
+
+    constexpr static auto event_count = static_cast<std::size_t>(Event::Count);
+    constexpr static std::array<const char *, event_count> event_names = {
+        "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses",
+    };
+
+    struct Counts {
+        std::array<uint64_t, event_count> values{};
+
+        auto operator[](Event event) const -> uint64_t { return values[static_cast<std::size_t>(event)]; }
+
+        auto operator-(const Counts &other) const -> Counts {
+            auto result = Counts{};
+            for (auto i = 0u; i < event_count; i++) {
+                result.values[i] = values[i] - other.values[i];
+            }
+            return result;
+        }
+    };
+
+    struct CounterGroup {
+        explicit CounterGroup(const char *name) : name(name) { fds.fill(-1); }
+        ~CounterGroup() { close(); }
+
+        CounterGroup(const CounterGroup &) = delete;
+        auto operator=(const CounterGroup &) -> CounterGroup & = delete;
+
+        // Events the CPU/kernel does not support are skipped, the group is usable as long as cycles opened
+        auto open() -> bool {
+#ifdef __linux__
+            for (auto i = 0u; i < event_count; i++) {
+                auto attr = perf_event_attr{};
+                attr.size = sizeof(perf_event_attr);
+                attr.disabled = i == 0u ? 1 : 0;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP;
+                set_event(attr, static_cast<Event>(i));
+
+                const auto leader = fds[0];
+                fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+                if (i == 0u && fds[i] < 0) {
+                    return false;
+                }
+                if (fds[i] >= 0) {
+                    opened.push_back(static_cast<Event>(i));
+                }
+            }
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        void close() {
+#ifdef __linux__
+            for (auto &fd : fds) {
+                if (fd >= 0) {
+                    ::close(fd);
+                    fd = -1;
+                }
+            }
+            opened.clear();
+#endif
+        }
+
+        auto is_open() const -> bool { return fds[0] >= 0; }
+
+        void enable() const {
+#ifdef __linux__
+            ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+        }
+
+        void disable() const {
+#ifdef __linux__
+            ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#endif
+        }
+
+        auto read() const -> Counts {
+            auto counts = Counts{};
+#ifdef __linux__
+            // PERF_FORMAT_GROUP layout: { u64 nr; u64 values[nr]; }
+            auto buffer = std::array<uint64_t, event_count + 1u>{};
+            if (::read(fds[0], buffer.data(), sizeof(buffer)) > 0) {
+                for (auto i = 0u; i < opened.size() && i < buffer[0]; i++) {
+                    counts.values[static_cast<std::size_t>(opened[i])] = buffer[i + 1u];
+                }
+            }
+#endif
+            return counts;
+        }
+
+        const char *name;
+
+      private:
+        std::array<int, event_count> fds{};
+        std::vector<Event> opened{};
+
+#ifdef __linux__
+        static void set_event(perf_event_attr &attr, Event event) {
+            constexpr auto cache_event = [](uint64_t cache, uint64_t op, uint64_t result) {
+                return cache | (op << 8u) | (result << 16u);
+            };
+
+            switch (event) {
+            case Event::Cycles:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case Event::Instructions:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case Event::L1dMisses:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                                          PERF_COUNT_HW_CACHE_RESULT_MISS);
+                break;
+            case Event::LlcMisses:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CACHE_MISSES;
+                break;
+            case Event::BranchMisses:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            case Event::Count:
+                break;
+            }
+        }
+#endif
+    };
+
+    // Group that is currently counting, scopes nest like a stack
+    inline CounterGroup *active_group = nullptr;
+
+    struct ScopedGroup {
+        explicit ScopedGroup(CounterGroup *group) : group(group), previous(active_group) {
+            if (group == nullptr) {
+                return;
+            }
+            if (previous != nullptr) {
+                previous->disable();
+            }
+            group->enable();
+            active_group = group;
+        }
+
+        ~ScopedGroup() {
+            if (group == nullptr) {
+                return;
+            }
+            group->disable();
+            if (previous != nullptr) {
+                previous->enable();
+            }
+            active_group = previous;
+        }
+
+        ScopedGroup(const ScopedGroup &) = delete;
+        auto operator=(const ScopedGroup &) -> ScopedGroup & = delete;
+
+      private:
+        CounterGroup *group;
+        CounterGroup *previous;
+    };
+
+    // Writes the per-frame difference of every group as CSV:
+    // frame,group,cycles,instructions,l1d_misses,llc_misses,branch_misses
+    struct FrameReport {
+        explicit FrameReport(const char *path) : file(std::fopen(path, "w")) {
+            if (file != nullptr) {
+                fmt::print(file, "frame,group");
+                for (const auto *event_name : event_names) {
+                    fmt::print(file, ",{}", event_name);
+                }
+                fmt::print(file, "\n");
+            }
+        }
+
+        ~FrameReport() {
+            if (file != nullptr) {
+                std::fclose(file);
+            }
+        }
+
+        FrameReport(const FrameReport &) = delete;
+        auto operator=(const FrameReport &) -> FrameReport & = delete;
+
+        void add_group(const CounterGroup *group) {
+            groups.push_back(group);
+            last_counts.push_back(group->read());
+        }
+
+        void end_frame() {
+            if (file == nullptr) {
+                return;
+            }
+
+            for (auto i = 0u; i < groups.size(); i++) {
+                const auto counts = groups[i]->read();
+                const auto delta = counts - last_counts[i];
+                last_counts[i] = counts;
+
+                fmt::print(file, "{},{}", frame, groups[i]->name);
+                for (const auto value : delta.values) {
+                    fmt::print(file, ",{}", value);
+                }
+                fmt::print(file, "\n");
+            }
+            frame++;
+        }
+
+      private:
+        std::FILE *file;
+        std::vector<const CounterGroup *> groups{};
+        std::vector<Counts> last_counts{};
+        uint64_t frame = 0u;
+    };
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "clockable_module.hpp"
+#include "interrupts.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <fmt/format.h>
+#include <imgui.h>
+#include <string>
+#include <vector>
+
+// ImGui overlay and JSON export for the numbers collected by `profiler.hpp`.
+// Rates are computed over the last `rate_window` so the overlay stays readable.
+struct PerformanceHud {
+    using SteadyClock = std::chrono::steady_clock;
+
+    constexpr static auto rate_window = std::chrono::milliseconds(500);
+    constexpr static std::size_t histogram_buckets = 25u;
+    constexpr static float histogram_bucket_ms = 2.0f;
+
+    struct DomainRates {
+        const char *name;
+        double evals_per_second;
+        double mhz;
+        double eval_share; // fraction of wall time spent in this domain's eval()
+    };
+
+    explicit PerformanceHud(const ClockScheduler *scheduler) : scheduler(scheduler) {}
+
+    // With SIM_INTERRUPTS, the latency histogram of every raised line is shown as well
+    const interrupts::Router *interrupt_router = nullptr;
+
+    // Call once per rendered frame
+    void end_frame() {
+        const auto now = SteadyClock::now();
+        frame_times.push(std::chrono::duration<float, std::milli>(now - last_frame).count());
+        last_frame = now;
+
+        if (now - window_start < rate_window) {
+            return;
+        }
+
+        const auto elapsed = std::chrono::duration<double>(now - window_start).count();
+        window_start = now;
+
+        previous.resize(scheduler->clocks.size());
+        rates.resize(scheduler->clocks.size());
+
+        for (auto i = 0u; i < scheduler->clocks.size(); i++) {
+            const auto *clock = scheduler->clocks[i];
+            const auto evals = clock->eval_stats.calls - previous[i].eval_stats.calls;
+            const auto eval_ticks = clock->eval_stats.ticks - previous[i].eval_stats.ticks;
+            const auto posedges = clock->posedges.calls - previous[i].posedges.calls;
+
+            rates[i] = DomainRates{
+                .name = clock->name,
+                .evals_per_second = static_cast<double>(evals) / elapsed,
+                .mhz = static_cast<double>(posedges) / elapsed / 1e6,
+                .eval_share = static_cast<double>(eval_ticks) / profiler::ticks_per_second() / elapsed,
+            };
+            previous[i] = {clock->eval_stats, clock->posedges};
+        }
+    }
+
+    void draw() const {
+        ImGui::SetNextWindowBgAlpha(0.75f);
+        ImGui::Begin("Performance", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+
+        if constexpr (!profiler::enabled) {
+            ImGui::TextUnformatted("Profiling is compiled out, configure with -DENABLE_PROFILING=ON");
+        }
+
+        if (ImGui::BeginTable("domains", 4)) {
+            ImGui::TableSetupColumn("domain");
+            ImGui::TableSetupColumn("evals/s");
+            ImGui::TableSetupColumn("MHz");
+            ImGui::TableSetupColumn("eval time");
+            ImGui::TableHeadersRow();
+
+            for (const auto &domain : rates) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(domain.name);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.0f", domain.evals_per_second);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", domain.mhz);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f%%", domain.eval_share * 100.0);
+            }
+            ImGui::EndTable();
+        }
+
+        const auto &zones = profiler::zones;
+        ImGui::Text("scheduler scan: %.3f s", zones.scheduler_advance.seconds());
+        ImGui::Text("vga rows: %.3f s", zones.vga_row.seconds());
+        ImGui::Text("draw callback: %.3f s", zones.draw_callback.seconds());
+        ImGui::Text("texture upload: %.3f s", zones.texture_upload.seconds());
+
+        const auto histogram = frame_time_histogram();
+        ImGui::PlotHistogram("frame time", histogram.data(), static_cast<int>(histogram.size()), 0,
+                             fmt::format("0 - {} ms", histogram_bucket_ms * histogram_buckets).c_str(), 0.0f,
+                             FLT_MAX, ImVec2(240, 60));
+
+        if (interrupt_router != nullptr) {
+            draw_interrupt_latencies();
+        }
+
+        ImGui::End();
+    }
+
+    auto write_json(const char *path) const -> bool {
+        auto *file = std::fopen(path, "w");
+        if (file == nullptr) {
+            return false;
+        }
+
+        const auto stat_json = [](const profiler::Stat &stat) {
+            return fmt::format(R"({{"calls": {}, "seconds": {}}})", stat.calls, stat.seconds());
+        };
+
+        fmt::print(file, "{{\n  \"domains\": [\n");
+        for (auto i = 0u; i < scheduler->clocks.size(); i++) {
+            const auto *clock = scheduler->clocks[i];
+            const auto rate = i < rates.size() ? rates[i] : DomainRates{clock->name, 0.0, 0.0, 0.0};
+            fmt::print(file,
+                       R"(    {{"name": "{}", "eval": {}, "posedges": {}, "evals_per_second": {}, "mhz": {}}}{})",
+                       clock->name, stat_json(clock->eval_stats), clock->posedges.calls, rate.evals_per_second,
+                       rate.mhz, i + 1 < scheduler->clocks.size() ? ",\n" : "\n");
+        }
+
+        const auto &zones = profiler::zones;
+        fmt::print(file, "  ],\n  \"zones\": {{\n");
+        fmt::print(file, "    \"scheduler_advance\": {},\n", stat_json(zones.scheduler_advance));
+        fmt::print(file, "    \"vga_row\": {},\n", stat_json(zones.vga_row));
+        fmt::print(file, "    \"draw_callback\": {},\n", stat_json(zones.draw_callback));
+        fmt::print(file, "    \"texture_upload\": {}\n", stat_json(zones.texture_upload));
+
+        fmt::print(file, "  }},\n  \"frame_ms\": [");
+        for (auto i = 0u; i < frame_times.size(); i++) {
+            const auto index = (frame_times.count - frame_times.size() + i) % profiler::FrameTimes::history_size;
+            fmt::print(file, "{}{}", i == 0u ? "" : ", ", frame_times.milliseconds[index]);
+        }
+        fmt::print(file, "]\n}}\n");
+
+        std::fclose(file);
+        return true;
+    }
+
+  private:
+    struct Snapshot {
+        profiler::Stat eval_stats;
+        profiler::Stat posedges;
+    };
+
+    const ClockScheduler *scheduler;
+    std::vector<Snapshot> previous{};
+    std::vector<DomainRates> rates{};
+    profiler::FrameTimes frame_times{};
+    SteadyClock::time_point last_frame = SteadyClock::now();
+    SteadyClock::time_point window_start = SteadyClock::now();
+
+    void draw_interrupt_latencies() const {
+        using interrupts::LatencyHistogram;
+        for (auto line = 0u; line < interrupts::line_count; line++) {
+            const auto &stats = interrupt_router->stats[line];
+            if (stats.raised == 0u) {
+                continue;
+            }
+
+            auto buckets = std::array<float, LatencyHistogram::bucket_count>{};
+            for (auto i = 0u; i < buckets.size(); i++) {
+                buckets[i] = static_cast<float>(stats.latency.buckets[i]);
+            }
+            const auto label = fmt::format("irq {} ({})", line, interrupt_router->line_name(line));
+            const auto overlay = fmt::format("{} raised, mean {:.1f} max {} cycles", stats.raised, stats.latency.mean(),
+                                             stats.latency.count == 0u ? 0u : stats.latency.max);
+            ImGui::PlotHistogram(label.c_str(), buckets.data(), static_cast<int>(buckets.size()), 0, overlay.c_str(),
+                                 0.0f, FLT_MAX, ImVec2(240, 60));
+        }
+        ImGui::TextUnformatted("latency buckets: 0, 1, 2-3, 4-7, ... cycles");
+    }
+
+    auto frame_time_histogram() const -> std::array<float, histogram_buckets> {
+        auto buckets = std::array<float, histogram_buckets>{};
+        for (auto i = 0u; i < frame_times.size(); i++) {
+            const auto bucket = static_cast<std::size_t>(frame_times.milliseconds[i] / histogram_bucket_ms);
+            buckets[std::min(bucket, histogram_buckets - 1u)] += 1.0f;
+        }
+        return buckets;
+    }
+};
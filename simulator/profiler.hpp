@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Lightweight host-side instrumentation. Everything below is always declared so the
+// simulator compiles the same way in both configurations, but `PROFILE_SCOPE`/`PROFILE_COUNT`
+// only expand to code when the build is configured with -DENABLE_PROFILING=ON.
+
+namespace profiler {
+#ifdef SIM_PROFILING
+    constexpr static bool enabled = true;
+#else
+    constexpr static bool enabled = false;
+#endif
+
+    // Raw timestamp - TSC where available, steady clock nanoseconds everywhere else
+    inline auto timestamp() -> uint64_t {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    // Number of `timestamp()` ticks per second, measured once on first use
+    inline auto ticks_per_second() -> double {
+        static const double value = [] {
+            const auto wall_start = std::chrono::steady_clock::now();
+            const auto start = timestamp();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            const auto ticks = timestamp() - start;
+            const auto wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start);
+            return static_cast<double>(ticks) / wall.count();
+        }();
+        return value;
+    }
+
+    struct Stat {
+        uint64_t calls = 0u;
+        uint64_t ticks = 0u;
+
+        void add(uint64_t elapsed) {
+            calls++;
+            ticks += elapsed;
+        }
+
+        auto seconds() const -> double { return static_cast<double>(ticks) / ticks_per_second(); }
+    };
+
+    struct ScopedTimer {
+        explicit ScopedTimer(Stat &stat) : stat(stat), start(timestamp()) {}
+        ~ScopedTimer() { stat.add(timestamp() - start); }
+
+        ScopedTimer(const ScopedTimer &) = delete;
+        auto operator=(const ScopedTimer &) -> ScopedTimer & = delete;
+
+      private:
+        Stat &stat;
+        uint64_t start;
+    };
+
+    // Host stages that do not belong to a single clock domain (clock domains keep their own stats)
+    struct Zones {
+        // the scheduler's scan for the next edge, without the evals it triggers
+        Stat scheduler_advance;
+        Stat vga_row;
+        Stat draw_callback;
+        Stat texture_upload;
+    };
+
+    inline Zones zones{};
+
+    // Last `history_size` frame times in milliseconds
+    struct FrameTimes {
+        constexpr static std::size_t history_size = 240u;
+
+        std::array<float, history_size> milliseconds{};
+        std::size_t count = 0u;
+
+        void push(float frame_ms) {
+            milliseconds[count % history_size] = frame_ms;
+            count++;
+        }
+
+        auto size() const -> std::size_t { return count < history_size ? count : history_size; }
+    };
+}
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef SIM_PROFILING
+#define PROFILE_SCOPE(stat) const profiler::ScopedTimer PROFILE_CONCAT(profile_scope_, __LINE__){stat}
+#define PROFILE_COUNT(stat) ((stat).calls++)
+#else
+#define PROFILE_SCOPE(stat) static_cast<void>(0)
+#define PROFILE_COUNT(stat) static_cast<void>(0)
+#endif
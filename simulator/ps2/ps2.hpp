@@ -1,18 +1,112 @@
 #pragma once
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
-#include <vector>
-#include <queue>
-#include <optional>
+#include <initializer_list>
+#include "ps2Lookup.hpp"
 #include "raylib.h"
+#include "ring_buffer.hpp"
 
-namespace ps2{
-    struct Packet{
-        std::array<bool,11> data{};
-        explicit Packet(uint8_t value);
+namespace ps2 {
+    // One PS/2 frame in the order it goes over the data line, bit i on the i-th clock: the start bit (0), the 8 data
+    // bits LSB first, odd parity and the stop bit (1)
+    using Frame = uint16_t;
+
+    constexpr auto make_frame(uint8_t value) -> Frame {
+        auto parity = 1u;
+        for (auto bits = value; bits != 0u; bits = static_cast<uint8_t>(bits >> 1u)) {
+            parity ^= bits & 1u;
+        }
+        return static_cast<Frame>(1u << 10u | parity << 9u | static_cast<unsigned>(value) << 1u);
+    }
+
+    constexpr auto frame_value(Frame frame) -> uint8_t { return static_cast<uint8_t>(frame >> 1u); }
+
+    // The frames one key event sends, the longest is the make code of Pause
+    struct Sequence {
+        std::array<Frame, 8> frames{};
+        uint8_t size = 0u;
+
+        constexpr auto begin() const { return frames.begin(); }
+        constexpr auto end() const { return frames.begin() + size; }
+        constexpr auto empty() const -> bool { return size == 0u; }
+
+        constexpr void push(uint8_t value) { frames[size++] = make_frame(value); }
     };
+
+    // Scan code set 2, keys without a scan code and the release of Pause send nothing
+    constexpr auto build_sequence(KeyboardKey key, bool isRelease) -> Sequence {
+        auto sequence = Sequence{};
+        const auto push = [&sequence](std::initializer_list<uint8_t> values) {
+            for (const auto value : values) {
+                sequence.push(value);
+            }
+        };
+
+        if (key == KEY_PRINT_SCREEN) {
+            if (isRelease) {
+                push({0xE0, 0xF0, 0x7C, 0xE0, 0xF0, 0x12});
+            } else {
+                push({0xE0, 0x12, 0xE0, 0x7C});
+            }
+            return sequence;
+        }
+        if (key == KEY_PAUSE) {
+            if (!isRelease) {
+                push({0xE1, 0x14, 0x77, 0xE1, 0xF0, 0x14, 0xE0, 0x77});
+            }
+            return sequence;
+        }
+
+        const auto code = key_to_scan_code(key);
+        if (const auto *value = std::get_if<uint8_t>(&code)) {
+            if (*value != 0u) {
+                if (isRelease) {
+                    push({0xF0});
+                }
+                push({*value});
+            }
+            return sequence;
+        }
+        const auto [prefix, value] = std::get<std::pair<uint8_t, uint8_t>>(code);
+        push({prefix});
+        if (isRelease) {
+            push({0xF0});
+        }
+        push({value});
+        return sequence;
+    }
+
+    // KEY_KB_MENU is the highest raylib key code
+    constexpr std::size_t key_count = KEY_KB_MENU + 1u;
+
+    struct KeySequences {
+        Sequence make;
+        Sequence release;
+    };
+
+    // Indexed by key code, the entry after the last key stays empty
+    inline constexpr auto key_sequences = [] {
+        auto table = std::array<KeySequences, key_count + 1u>{};
+        for (auto key = 0u; key < key_count; key++) {
+            table[key] = {build_sequence(static_cast<KeyboardKey>(key), false),
+                          build_sequence(static_cast<KeyboardKey>(key), true)};
+        }
+        return table;
+    }();
+
+    // Keys past the table send nothing, like the ones without a scan code
+    constexpr auto encode_key(KeyboardKey key, bool isRelease) -> const Sequence & {
+        const auto &sequences = key_sequences[std::min(static_cast<std::size_t>(key), key_count)];
+        return isRelease ? sequences.release : sequences.make;
+    }
+
     struct Keyboard {
-        std::queue<Packet> packets_to_send;
-        auto encode_key(KeyboardKey key,bool isRelease) -> std::optional<std::vector<Packet>>;
+        RingBuffer<Frame, 64> frames_to_send{};
+
+        // Queues every frame of the key event or, when they don't all fit, none of them. Returns false if the event
+        // was dropped.
+        auto send_key(KeyboardKey key, bool isRelease) -> bool;
     };
 }
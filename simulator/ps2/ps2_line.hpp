@@ -0,0 +1,179 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include "clockable_module.hpp"
+#include "ps2.hpp"
+
+// The keyboard side of the PS/2 clock and data lines as a clock domain of the `ClockScheduler`.
+//
+// `LineDriver` shifts the frames queued in a `Keyboard` out at the PS/2 clock rate: data changes while the clock is
+// high and the host samples it on the falling edge. With nothing queued the driver has no next tick. `schedule` keeps
+// it in the scheduler only while it has something to send, so an idle keyboard costs the hot loop nothing. Frames are
+// queued between scheduler advances, the start bit goes out at the next advance.
+
+namespace ps2 {
+    // Whatever the lines are wired to, a verilated module with `ps2_clk` and `ps2_data` inputs or `Receiver`
+    template <typename T>
+    concept Port = requires(T port) {
+        port.ps2_clk;
+        port.ps2_data;
+        port.eval();
+    };
+
+    // Scheduler time units in half a PS/2 clock cycle. Keyboards clock at 10 to 16.7 kHz, `units_per_second` is the
+    // rate of a period of 1, the VGA pixel clock in the simulator.
+    constexpr auto clock_half_period(uint64_t units_per_second, uint32_t clock_hz = 12'500u) -> uint32_t {
+        return static_cast<uint32_t>(units_per_second / (2u * clock_hz));
+    }
+
+    template <Port T> struct LineDriver : ClockBase {
+        constexpr static uint32_t frame_bits = 11u;
+
+        LineDriver(Keyboard *keyboard, T *port, uint32_t half_period)
+            : half_period{half_period}, keyboard(keyboard), port(port) {
+            assert(half_period != 0u);
+            name = "ps2";
+            drive(true, true);
+        }
+
+        // Every half clock cycle while a frame is sent
+        void tick() override {
+            time_since_last_tick = 0u;
+            if (clock_high) {
+                drive(false, data_bit());
+                PROFILE_COUNT(posedges);
+                return;
+            }
+
+            bit++;
+            if (bit < frame_bits) {
+                drive(true, data_bit());
+                return;
+            }
+
+            // the stop bit leaves the data line high, which is idle
+            drive(true, true);
+            frames_sent++;
+            sending = false;
+        }
+
+        void advance(uint32_t delta) override {
+            if (!sending) {
+                if (keyboard->frames_to_send.empty()) {
+                    return;
+                }
+                start_frame();
+            }
+
+            time_since_last_tick += delta;
+            if (time_since_last_tick == half_period) {
+                tick();
+            } else if (time_since_last_tick > half_period) {
+                fmt::println("PS/2 clock overshot by {} cycles", time_since_last_tick - half_period);
+            }
+        }
+
+        auto get_time_till_next_tick() const -> uint32_t override {
+            if (idle()) {
+                return std::numeric_limits<uint32_t>::max();
+            }
+            return half_period - time_since_last_tick;
+        }
+
+        auto idle() const -> bool { return !sending && keyboard->frames_to_send.empty(); }
+
+        // Adds the driver to `scheduler` once frames are queued and removes it again when it is idle. Call it between
+        // scheduler advances, after queueing key events and every so often while it sends.
+        void schedule(ClockScheduler &scheduler) {
+            if (scheduled != idle()) {
+                return;
+            }
+            if (scheduled) {
+                scheduler.remove_clock(this);
+            } else {
+                scheduler.add_clock(this);
+            }
+            scheduled = !scheduled;
+        }
+
+        const uint32_t half_period;
+        uint64_t frames_sent = 0u;
+
+      private:
+        void start_frame() {
+            frame = *keyboard->frames_to_send.pop();
+            bit = 0u;
+            sending = true;
+            time_since_last_tick = 0u;
+            drive(true, data_bit());
+        }
+
+        auto data_bit() const -> bool { return (frame >> bit & 1u) != 0u; }
+
+        void drive(bool clock, bool data) {
+            clock_high = clock;
+            port->ps2_clk = clock;
+            port->ps2_data = data;
+            PROFILE_SCOPE(eval_stats);
+            const perf::ScopedGroup perf_scope{perf_group};
+            port->eval();
+        }
+
+        Keyboard *keyboard;
+        T *port;
+
+        Frame frame = 0u;
+        uint32_t bit = 0u;
+        bool sending = false;
+        bool scheduled = false;
+        bool clock_high = true;
+        uint32_t time_since_last_tick = 0u;
+    };
+
+    // The host side of the lines, a keyboard controller with a one byte data register. `interrupt` is raised for
+    // every received byte and cleared by `read`, a byte received before the last one was read overwrites it.
+    struct Receiver {
+        uint8_t ps2_clk = 1u;
+        uint8_t ps2_data = 1u;
+
+        bool interrupt = false;
+        uint8_t data = 0u;
+        // frames with a wrong start, parity or stop bit, they are dropped
+        uint64_t frame_errors = 0u;
+        uint64_t overruns = 0u;
+
+        void eval() {
+            const auto falling = last_clk != 0u && ps2_clk == 0u;
+            last_clk = ps2_clk;
+            if (!falling) {
+                return;
+            }
+
+            shift |= static_cast<Frame>((ps2_data & 1u) << bits);
+            if (++bits < 11u) {
+                return;
+            }
+
+            const auto frame = shift;
+            shift = 0u;
+            bits = 0u;
+            if (frame != make_frame(frame_value(frame))) {
+                frame_errors++;
+                return;
+            }
+            overruns += interrupt ? 1u : 0u;
+            data = frame_value(frame);
+            interrupt = true;
+        }
+
+        auto read() -> uint8_t {
+            interrupt = false;
+            return data;
+        }
+
+      private:
+        uint8_t last_clk = 1u;
+        Frame shift = 0u;
+        uint32_t bits = 0u;
+    };
+}
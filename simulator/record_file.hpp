@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// The files the simulator records (GPU commands, input, bus traces, video) all start with an 8 byte magic.
+// `create` and `read_file` handle the magic for every format, `Writer` and `read_records` the formats that are a
+// plain stream of fixed size records. Fields are stored little endian with `store` and `load`.
+
+namespace record_file {
+    using Magic = char[8];
+
+    // Opens `path` for writing and writes `magic`, nullptr when it can't be opened
+    inline auto create(const std::string &path, const Magic &magic) -> std::FILE * {
+        auto *file = std::fopen(path.c_str(), "wb");
+        if (file != nullptr) {
+            std::fwrite(magic, sizeof(Magic), 1, file);
+        }
+        return file;
+    }
+
+    // Everything after the magic, nullopt when the file is missing or starts with another magic
+    inline auto read_file(const std::string &path, const Magic &magic) -> std::optional<std::vector<uint8_t>> {
+        auto *file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            return std::nullopt;
+        }
+
+        auto bytes = std::vector<uint8_t>{};
+        auto chunk = std::array<uint8_t, 1u << 16>{};
+        for (auto n = std::fread(chunk.data(), 1, chunk.size(), file); n > 0u;
+             n = std::fread(chunk.data(), 1, chunk.size(), file)) {
+            bytes.insert(bytes.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(n));
+        }
+        std::fclose(file);
+
+        if (bytes.size() < sizeof(Magic) || std::memcmp(bytes.data(), magic, sizeof(Magic)) != 0) {
+            return std::nullopt;
+        }
+        bytes.erase(bytes.begin(), bytes.begin() + sizeof(Magic));
+        return bytes;
+    }
+
+    template <std::unsigned_integral T> constexpr void store(uint8_t *out, T value) {
+        for (auto i = 0u; i < sizeof(T); i++) {
+            out[i] = static_cast<uint8_t>(value >> (8u * i));
+        }
+    }
+
+    template <std::unsigned_integral T> constexpr auto load(const uint8_t *in) -> T {
+        auto value = T{0};
+        for (auto i = 0u; i < sizeof(T); i++) {
+            value = static_cast<T>(value | static_cast<T>(in[i]) << (8u * i));
+        }
+        return value;
+    }
+
+    template <std::size_t Size> using Record = std::array<uint8_t, Size>;
+
+    template <std::size_t Size> struct Writer {
+        Writer(const std::string &path, const Magic &magic) : file(create(path, magic)) {}
+
+        ~Writer() {
+            if (file != nullptr) {
+                std::fclose(file);
+            }
+        }
+
+        Writer(const Writer &) = delete;
+        auto operator=(const Writer &) -> Writer & = delete;
+
+        auto is_open() const -> bool { return file != nullptr; }
+
+        void write(const Record<Size> &record) {
+            if (file != nullptr) {
+                std::fwrite(record.data(), record.size(), 1, file);
+            }
+        }
+
+      private:
+        std::FILE *file;
+    };
+
+    // Decodes every record with `decode`, which returns an optional. The whole read fails when the file is missing,
+    // has another magic, ends in a partial record or a record doesn't decode.
+    template <std::size_t Size, typename Decode>
+    auto read_records(const std::string &path, const Magic &magic, Decode decode)
+        -> std::optional<std::vector<typename std::invoke_result_t<Decode, const Record<Size> &>::value_type>> {
+        const auto bytes = read_file(path, magic);
+        if (!bytes || bytes->size() % Size != 0u) {
+            return std::nullopt;
+        }
+
+        auto records = std::vector<typename std::invoke_result_t<Decode, const Record<Size> &>::value_type>{};
+        records.reserve(bytes->size() / Size);
+        auto record = Record<Size>{};
+        for (auto pos = std::size_t{0}; pos < bytes->size(); pos += Size) {
+            std::memcpy(record.data(), bytes->data() + pos, Size);
+            const auto decoded = decode(record);
+            if (!decoded) {
+                return std::nullopt;
+            }
+            records.push_back(*decoded);
+        }
+        return records;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <optional>
+
+// Lock-free single-producer/single-consumer ring buffer.
+// The producer (usually the simulation thread) only touches `head`, the consumer only touches `tail`,
+// so neither side ever blocks - a full buffer is reported by `push` returning false.
+template <typename T, std::size_t Capacity> struct RingBuffer {
+    static_assert(std::has_single_bit(Capacity), "RingBuffer capacity must be a power of two");
+
+    auto push(const T &value) -> bool {
+        const auto current_head = head.load(std::memory_order_relaxed);
+        if (current_head - tail.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+
+        storage[current_head & mask] = value;
+        head.store(current_head + 1, std::memory_order_release);
+        return true;
+    }
+
+    auto pop() -> std::optional<T> {
+        const auto current_tail = tail.load(std::memory_order_relaxed);
+        if (current_tail == head.load(std::memory_order_acquire)) {
+            return std::nullopt;
+        }
+
+        auto value = storage[current_tail & mask];
+        tail.store(current_tail + 1, std::memory_order_release);
+        return value;
+    }
+
+    // Pops everything that was pushed before the call, returns the number of consumed elements
+    template <typename F> auto drain(F &&consume) -> std::size_t {
+        const auto current_tail = tail.load(std::memory_order_relaxed);
+        const auto current_head = head.load(std::memory_order_acquire);
+
+        for (auto i = current_tail; i != current_head; i++) {
+            consume(storage[i & mask]);
+        }
+
+        tail.store(current_head, std::memory_order_release);
+        return current_head - current_tail;
+    }
+
+    auto size() const -> std::size_t {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    auto empty() const -> bool { return size() == 0u; }
+
+    constexpr static auto capacity() -> std::size_t { return Capacity; }
+
+  private:
+    constexpr static std::size_t mask = Capacity - 1u;
+
+    alignas(64) std::atomic<std::size_t> head{0u};
+    alignas(64) std::atomic<std::size_t> tail{0u};
+    std::array<T, Capacity> storage{};
+};
@@ -0,0 +1,178 @@
+#pragma once
+#include "vga_timing.hpp"
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <variant>
+
+// Which frames `SyncChecker` validates. Once the timing of a driver is known to be good, checking only the first
+// frame or every Nth frame saves the per-tick work on the others.
+struct SyncValidation {
+    enum class Level : uint8_t { EveryFrame, EveryNthFrame, FirstFrame };
+
+    Level level = Level::EveryFrame;
+    // for EveryNthFrame, frames 0, interval, 2 * interval, ... are checked
+    uint32_t interval = 1u;
+};
+
+// "all", "first" or a frame interval
+inline auto parse_sync_validation(std::string_view text) -> std::optional<SyncValidation> {
+    if (text == "all") {
+        return SyncValidation{};
+    }
+    if (text == "first") {
+        return SyncValidation{.level = SyncValidation::Level::FirstFrame};
+    }
+
+    auto interval = uint32_t{0};
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), interval);
+    if (error != std::errc{} || end != text.data() + text.size() || interval == 0u) {
+        return std::nullopt;
+    }
+    return SyncValidation{.level = SyncValidation::Level::EveryNthFrame, .interval = interval};
+}
+
+struct SyncViolations {
+    // indexed like the alternatives of VGASimulatorError
+    std::array<uint64_t, std::variant_size_v<VGASimulatorError>> counts{};
+    uint64_t frames_checked = 0u;
+    uint64_t frames_skipped = 0u;
+    std::optional<VGASimulatorError> first{};
+    uint64_t first_frame = 0u;
+
+    template <typename Error> auto count() const -> uint64_t { return counts[VGASimulatorError{Error{}}.index()]; }
+
+    auto total() const -> uint64_t {
+        auto sum = uint64_t{0};
+        for (const auto count : counts) {
+            sum += count;
+        }
+        return sum;
+    }
+};
+
+// Streaming check of the hsync and vsync timing, fed one sample per tick of a frame. It keeps only the edges of the
+// current line and frame, and counts every violation instead of stopping at the first one.
+//
+// Positions follow `VGASimulator`: a frame starts at the first visible tick and has one line more than `Timing`
+// (gpu.sv shows 481 lines), and vsync is sampled at the end of each line.
+template <VGATiming Timing> struct SyncChecker {
+    constexpr static auto frame_lines = Timing.v_total() + 1u;
+    // the column the hsync pulse is first seen in, one before the end of the front porch
+    constexpr static auto hsync_start = Timing.h_visible_area + Timing.h_front_porch - 1u;
+    constexpr static auto vsync_start = Timing.v_visible_area + Timing.v_front_porch;
+
+    SyncValidation validation{};
+
+    // Forgets the counts, the next frame is the first one again
+    void reset() {
+        violations = {};
+        frame = 0u;
+    }
+
+    // Whether the coming frame is checked, if so `sample` has to be called for each of its ticks and `end_frame`
+    // after the last one
+    auto begin_frame() -> bool {
+        const auto index = frame++;
+        const auto checked = validation.level == SyncValidation::Level::EveryFrame ||
+                             (validation.level == SyncValidation::Level::EveryNthFrame &&
+                              index % validation.interval == 0u) ||
+                             (validation.level == SyncValidation::Level::FirstFrame && index == 0u);
+        if (!checked) {
+            violations.frames_skipped++;
+            return false;
+        }
+
+        column = 0u;
+        line = 0u;
+        hsync = {};
+        vsync = {};
+        frame_error.reset();
+        return true;
+    }
+
+    void sample(bool hsync_asserted, bool vsync_asserted) {
+        hsync.sample(hsync_asserted, column);
+        if (++column == Timing.h_total()) {
+            check(hsync, true, Timing.h_sync_pulse_width, hsync_start, Timing.h_total());
+            hsync = {};
+            column = 0u;
+            vsync.sample(vsync_asserted, line);
+            line++;
+        }
+    }
+
+    // Checks the vertical timing, returns the first violation of the frame
+    auto end_frame() -> std::optional<VGASimulatorError> {
+        if (column != 0u || line != frame_lines) {
+            record(IncorrectRowTiming{.row = line});
+        }
+        check(vsync, false, Timing.v_sync_pulse_width, vsync_start, frame_lines);
+        violations.frames_checked++;
+        return frame_error;
+    }
+
+    auto result() const -> const SyncViolations & { return violations; }
+
+  private:
+    // The edges of one sync signal within a line or a frame
+    struct Pulse {
+        uint32_t start = 0u;
+        uint32_t end = 0u;
+        uint32_t pulses = 0u;
+        bool asserted = false;
+
+        void sample(bool level, uint32_t position) {
+            if (level && !asserted && pulses++ == 0u) {
+                start = position;
+            } else if (!level && asserted && pulses == 1u) {
+                end = position;
+            }
+            asserted = level;
+        }
+    };
+
+    void check(const Pulse &pulse, bool is_hsync, uint32_t width, uint32_t start, uint32_t length) {
+        if (pulse.pulses == 0u) {
+            if (is_hsync) {
+                record(HSyncUndetected{});
+            } else {
+                record(VSyncUndetected{});
+            }
+            return;
+        }
+        if (pulse.pulses > 1u) {
+            record(MultiplePulsesDetected{.is_hsync = is_hsync});
+        }
+
+        // a pulse still going at the end is cut there
+        const auto end = pulse.pulses == 1u && pulse.asserted ? length : pulse.end;
+        if (end - pulse.start != width) {
+            record(IncorrectPulseWidth{.is_hsync = is_hsync, .expected = width, .actual = end - pulse.start});
+        }
+        if (pulse.start != start) {
+            record(IncorrectSyncTiming{.is_hsync = is_hsync, .expected = start, .actual = pulse.start});
+        }
+    }
+
+    void record(const VGASimulatorError &error) {
+        violations.counts[error.index()]++;
+        if (!frame_error) {
+            frame_error = error;
+        }
+        if (!violations.first) {
+            violations.first = error;
+            violations.first_frame = frame - 1u;
+        }
+    }
+
+    SyncViolations violations{};
+    std::optional<VGASimulatorError> frame_error{};
+    uint64_t frame = 0u;
+    uint32_t column = 0u;
+    uint32_t line = 0u;
+    Pulse hsync{};
+    Pulse vsync{};
+};
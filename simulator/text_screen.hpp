@@ -0,0 +1,82 @@
+#pragma once
+#include <Vgpu.h>
+#include <Vgpu___024root.h>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// The 80x60 text grid the GPU shows, read straight out of its char_buf and color_buf instead of rendering and
+// decoding 307200 pixels. Reading a screen costs a few microseconds, see tests/gpu/screen_checks.hpp for the doctest
+// helpers built on it.
+
+struct TextCell {
+    uint8_t character;
+    uint8_t color;
+
+    auto operator==(const TextCell &) const -> bool = default;
+};
+
+struct TextScreen {
+    constexpr static uint32_t columns = 80u;
+    constexpr static uint32_t rows = 60u;
+
+    std::array<TextCell, columns * rows> cells{};
+
+    auto at(uint32_t column, uint32_t row) const -> const TextCell & { return cells[row * columns + column]; }
+
+    // Never written cells hold 0, they read as spaces like cleared ones. Trailing spaces are cut.
+    auto row_text(uint32_t row) const -> std::string {
+        auto text = std::string(columns, ' ');
+        for (auto column = 0u; column < columns; column++) {
+            const auto character = at(column, row).character;
+            text[column] = character == 0u ? ' ' : static_cast<char>(character);
+        }
+        text.erase(text.find_last_not_of(' ') + 1u);
+        return text;
+    }
+
+    // All rows separated by newlines, without the trailing empty rows
+    auto text() const -> std::string {
+        auto text = std::string{};
+        for (auto row = 0u; row < rows; row++) {
+            text += row_text(row);
+            text += '\n';
+        }
+        text.erase(text.find_last_not_of('\n') + 1u);
+        return text;
+    }
+
+    // Column and row of the first occurrence of `needle` within a row
+    auto find(std::string_view needle) const -> std::optional<std::pair<uint32_t, uint32_t>> {
+        for (auto row = 0u; row < rows; row++) {
+            if (const auto column = row_text(row).find(needle); column != std::string::npos) {
+                return std::pair{static_cast<uint32_t>(column), row};
+            }
+        }
+        return std::nullopt;
+    }
+};
+
+// The two pages of char_buf and color_buf relative to `display_page`: the one on the display and the other one, which
+// double buffering writes to
+enum class ScreenPage : uint8_t { Shown, Back };
+
+// The screen as `page` shows it with the current scroll offset
+inline auto read_text_screen(const Vgpu &gpu, ScreenPage page = ScreenPage::Shown) -> TextScreen {
+    // char_buf and color_buf are addressed as {page, cell}, screen row r shows row (r + scroll_row) mod 60
+    constexpr auto page_size = 1u << 13u;
+    const auto *root = gpu.rootp;
+    const auto shown = gpu.display_page != 0u;
+    const auto base = ((page == ScreenPage::Shown) == shown ? 1u : 0u) * page_size;
+    const auto first_cell = root->gpu__DOT__scroll_row * TextScreen::columns;
+
+    auto screen = TextScreen{};
+    for (auto i = 0u; i < screen.cells.size(); i++) {
+        const auto cell = base + (first_cell + i) % static_cast<uint32_t>(screen.cells.size());
+        screen.cells[i] = {root->gpu__DOT__char_buf__DOT__mem[cell], root->gpu__DOT__color_buf__DOT__mem[cell]};
+    }
+    return screen;
+}
@@ -0,0 +1,146 @@
+#include "trace.hpp"
+#include <algorithm>
+#include <array>
+#include <csignal>
+#include <fstapi.h>
+
+const std::array<const char *, 48> trace::signal_names = {
+    "REG_A_LOAD",        "REG_B_LOAD",         "ALU_OPC_0",          "ALU_OPC_1",         "ALU_OPC_2",
+    "ALU_OPC_3",         "ALU_OPC_4",          "REG_F_LOAD",         "REG_F_OUT",         "ALU_OUT",
+    "REG_TMPH_LOAD",     "REG_TMPL_LOAD",      "REG_TMPH_OUT",       "REG_TMPL_OUT",      "REG_TMP_PASS_ADDRESS",
+    "REG_TMPH_PASS_DATA", "REG_TMPL_PASS_DATA", "REG_TMP_ADDRESS_DIR", "REG_TMPH_DATA_DIR", "REG_TMPL_DATA_DIR",
+    "PC_LOAD",           "PC_RST",             "PC_TICK",            "PC_OUT",            "STC_LOAD",
+    "STC_RST",           "STC_TICK",           "STC_MODE",           "STC_OUT",           "REG_MAR_LOAD",
+    "REG_MBR_LOAD",      "MEM_OUT",            "MEM_IN",             "MEM_PART",          "ZERO_PAGE",
+    "REG_MBR_WORD_DIR",  "REG_MAR_USE_BTTNS",  "REG_MBR_USE_BTTNS",  "REG_MBR_USE_BUS",   "REG_IR_LOAD",
+    "MCC_TICK",          "MCC_RST",            "INT0",               "INT1",              "INT2",
+    "INT3",              "INT4",               "INT_ADDRESS_OUT",
+};
+
+namespace {
+    struct Handles {
+        fstHandle signals;
+        std::array<fstHandle, 48> signal_bits;
+        fstHandle addr_bus;
+        fstHandle pc;
+        fstHandle bus;
+        fstHandle a;
+        fstHandle b;
+        fstHandle flags;
+    };
+
+    auto create_handles(void *fst, const std::string &scope) -> Handles {
+        auto handles = Handles{};
+
+        fstWriterSetScope(fst, FST_ST_VCD_MODULE, scope.c_str(), nullptr);
+        handles.signals = fstWriterCreateVar(fst, FST_VT_VCD_WIRE, FST_VD_IMPLICIT, 48, "signals", 0);
+        handles.addr_bus = fstWriterCreateVar(fst, FST_VT_VCD_WIRE, FST_VD_IMPLICIT, 16, "addr_bus", 0);
+        handles.pc = fstWriterCreateVar(fst, FST_VT_VCD_WIRE, FST_VD_IMPLICIT, 16, "pc", 0);
+        handles.bus = fstWriterCreateVar(fst, FST_VT_VCD_WIRE, FST_VD_IMPLICIT, 8, "bus", 0);
+        handles.a = fstWriterCreateVar(fst, FST_VT_VCD_WIRE, FST_VD_IMPLICIT, 8, "a", 0);
+        handles.b = fstWriterCreateVar(fst, FST_VT_VCD_WIRE, FST_VD_IMPLICIT, 8, "b", 0);
+        handles.flags = fstWriterCreateVar(fst, FST_VT_VCD_WIRE, FST_VD_IMPLICIT, 8, "flags", 0);
+
+        fstWriterSetScope(fst, FST_ST_VCD_MODULE, "signal", nullptr);
+        for (auto i = 0u; i < trace::signal_names.size(); i++) {
+            handles.signal_bits[i] =
+                fstWriterCreateVar(fst, FST_VT_VCD_WIRE, FST_VD_IMPLICIT, 1, trace::signal_names[i], 0);
+        }
+        fstWriterSetUpscope(fst);
+
+        fstWriterSetUpscope(fst);
+        return handles;
+    }
+
+    void emit(void *fst, fstHandle handle, uint64_t value, uint32_t width) {
+        auto bits = std::array<char, 65>{};
+        for (auto i = 0u; i < width; i++) {
+            bits[i] = (value >> (width - 1u - i)) & 1u ? '1' : '0';
+        }
+        fstWriterEmitValueChange(fst, handle, bits.data());
+    }
+
+    void emit_sample(void *fst, const Handles &handles, const trace::CpuSample &sample,
+                     const trace::CpuSample *previous) {
+        if (previous == nullptr || previous->signals != sample.signals) {
+            emit(fst, handles.signals, sample.signals, 48);
+            for (auto i = 0u; i < handles.signal_bits.size(); i++) {
+                if (previous == nullptr || ((previous->signals ^ sample.signals) >> i & 1u)) {
+                    emit(fst, handles.signal_bits[i], sample.signals >> i, 1);
+                }
+            }
+        }
+        if (previous == nullptr || previous->addr_bus != sample.addr_bus) {
+            emit(fst, handles.addr_bus, sample.addr_bus, 16);
+        }
+        if (previous == nullptr || previous->pc != sample.pc) {
+            emit(fst, handles.pc, sample.pc, 16);
+        }
+        if (previous == nullptr || previous->bus != sample.bus) {
+            emit(fst, handles.bus, sample.bus, 8);
+        }
+        if (previous == nullptr || previous->a != sample.a) {
+            emit(fst, handles.a, sample.a, 8);
+        }
+        if (previous == nullptr || previous->b != sample.b) {
+            emit(fst, handles.b, sample.b, 8);
+        }
+        if (previous == nullptr || previous->flags != sample.flags) {
+            emit(fst, handles.flags, sample.flags, 8);
+        }
+    }
+
+    struct Entry {
+        const trace::CpuSample *sample;
+        std::size_t recorder;
+    };
+
+    const trace::CpuRecorder *abort_recorder = nullptr;
+    const char *abort_path = nullptr;
+
+    void dump_and_abort(int signal) {
+        std::signal(signal, SIG_DFL);
+        if (abort_recorder != nullptr) {
+            trace::write_fst(abort_path, *abort_recorder);
+        }
+        std::raise(signal);
+    }
+}
+
+auto trace::write_fst(const std::string &path, std::span<const CpuRecorder *const> recorders) -> bool {
+    auto *fst = fstWriterCreate(path.c_str(), 1);
+    if (fst == nullptr) {
+        return false;
+    }
+    fstWriterSetTimescaleFromString(fst, "1ns");
+
+    auto handles = std::vector<Handles>{};
+    auto entries = std::vector<Entry>{};
+    for (auto i = 0u; i < recorders.size(); i++) {
+        handles.push_back(create_handles(fst, recorders[i]->name));
+        recorders[i]->window.for_each([&](const CpuSample &sample) {
+            if (sample.time >= recorders[i]->first_time) {
+                entries.push_back({&sample, i});
+            }
+        });
+    }
+
+    // FST wants the time to only go forward, recorders that ran in lockstep are interleaved
+    std::ranges::stable_sort(entries, {}, [](const Entry &entry) { return entry.sample->time; });
+
+    auto previous = std::vector<const CpuSample *>(recorders.size(), nullptr);
+    for (const auto &entry : entries) {
+        fstWriterEmitTimeChange(fst, entry.sample->time);
+        emit_sample(fst, handles[entry.recorder], *entry.sample, previous[entry.recorder]);
+        previous[entry.recorder] = entry.sample;
+    }
+
+    fstWriterClose(fst);
+    return true;
+}
+
+void trace::dump_on_abort(const CpuRecorder *recorder, const char *path) {
+    abort_recorder = recorder;
+    abort_path = path;
+    std::signal(SIGABRT, recorder != nullptr ? dump_and_abort : SIG_DFL);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Windowed waveform tracing of the CPU.
+//
+// A full FST/VCD trace of the model is too slow and too large to leave on, so `CpuRecorder` only keeps the last
+// N cycles of a few signals in memory: one `CpuSample` per eval, overwriting the oldest one. The window is
+// written to an FST file only when it is needed - a failed test (tests/cpu/trace_on_failure.hpp), an abort or
+// a hotkey in the simulator.
+//
+// The internal buses and flags are read through `verilator public_flat_rd` signals of cpu.v.
+
+namespace trace {
+    struct CpuSample {
+        uint64_t time;
+        uint64_t signals; // the 48 control signals of the microcode, see cpu/include/signals.v
+        uint16_t addr_bus;
+        uint16_t pc;
+        uint8_t bus;
+        uint8_t a;
+        uint8_t b;
+        uint8_t flags;
+    };
+
+    // Bit order of cpu/include/signals.v
+    extern const std::array<const char *, 48> signal_names;
+
+    // `Cpu` is Vcpu or Vcpu_mux, the caller has to include its `___024root.h`
+    template <typename Cpu> auto sample_of(const Cpu &cpu, uint64_t time) -> CpuSample {
+        const auto *root = cpu.rootp;
+        return {
+            .time = time,
+            .signals = root->cpu_adapter__DOT__cpu__DOT__signals,
+            .addr_bus = cpu.addr_bus,
+            .pc = root->cpu_adapter__DOT__cpu__DOT__pc_out,
+            .bus = root->cpu_adapter__DOT__cpu__DOT__bus,
+            .a = root->cpu_adapter__DOT__cpu__DOT__a_out,
+            .b = root->cpu_adapter__DOT__cpu__DOT__b_out,
+            .flags = root->cpu_adapter__DOT__cpu__DOT__flags,
+        };
+    }
+
+    // Keeps the newest `capacity()` values, the capacity is rounded up to a power of two
+    template <typename T> struct Window {
+        explicit Window(std::size_t capacity) : storage(std::bit_ceil(capacity < 2u ? 2u : capacity)) {}
+
+        void record(const T &value) {
+            storage[head & mask()] = value;
+            head++;
+        }
+
+        void clear() { head = 0u; }
+
+        auto size() const -> std::size_t { return head < storage.size() ? head : storage.size(); }
+        auto capacity() const -> std::size_t { return storage.size(); }
+
+        // Oldest value first
+        template <typename F> void for_each(F &&consume) const {
+            for (auto i = head - size(); i != head; i++) {
+                consume(storage[i & mask()]);
+            }
+        }
+
+      private:
+        auto mask() const -> std::size_t { return storage.size() - 1u; }
+
+        std::vector<T> storage;
+        std::size_t head = 0u;
+    };
+
+    struct CpuRecorder {
+        // `cycles` full clock cycles are kept, every eval (both edges) takes a sample
+        CpuRecorder(std::string name, std::size_t cycles) : name(std::move(name)), window(cycles * 2u) {}
+
+        template <typename Cpu> void capture(const Cpu &cpu) { record(sample_of(cpu, time)); }
+
+        void record(const CpuSample &sample) {
+            window.record(sample);
+            time = sample.time + 1u;
+        }
+
+        // Scope of the recorder in the FST file
+        std::string name;
+        Window<CpuSample> window;
+        uint64_t time = 0u;
+        // Samples older than this are not written
+        uint64_t first_time = 0u;
+    };
+
+    // Writes the windows of all `recorders` into one FST file, one scope per recorder.
+    // The time unit is one eval (half a clock cycle).
+    auto write_fst(const std::string &path, std::span<const CpuRecorder *const> recorders) -> bool;
+
+    inline auto write_fst(const std::string &path, const CpuRecorder &recorder) -> bool {
+        const CpuRecorder *recorders[] = {&recorder};
+        return write_fst(path, recorders);
+    }
+
+    // Writes `recorder` to `path` when the process aborts (failed assert(), std::terminate), pass nullptr to
+    // disarm. Meant for debugging only, the handler is not async-signal-safe.
+    void dump_on_abort(const CpuRecorder *recorder, const char *path);
+}
@@ -0,0 +1,193 @@
+#include "trigger.hpp"
+#include <algorithm>
+#include <charconv>
+#include <fmt/base.h>
+
+namespace {
+    // REG_IR_LOAD in cpu/include/signals.v
+    constexpr auto ir_load_bit = 39u;
+
+    auto parse_hex(std::string_view text) -> std::optional<uint64_t> {
+        auto value = uint64_t{0};
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, 16);
+        if (error != std::errc{} || end != text.data() + text.size()) {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    auto parse_range(std::string_view text, trace::Trigger trigger) -> std::optional<trace::Trigger> {
+        const auto dash = text.find('-');
+        const auto low = parse_hex(text.substr(0, dash));
+        const auto high = dash == std::string_view::npos ? low : parse_hex(text.substr(dash + 1));
+        if (!low || !high) {
+            return std::nullopt;
+        }
+
+        trigger.low = *low;
+        trigger.high = *high;
+        return trigger;
+    }
+}
+
+auto trace::parse_trigger(std::string_view condition) -> std::optional<Trigger> {
+    const auto colon = condition.find(':');
+    if (colon == std::string_view::npos) {
+        return std::nullopt;
+    }
+
+    const auto kind = condition.substr(0, colon);
+    const auto argument = condition.substr(colon + 1);
+
+    if (kind == "pc") {
+        return parse_range(argument, {.field = Trigger::Field::Pc});
+    }
+    if (kind == "opcode") {
+        return parse_range(argument, {.field = Trigger::Field::Opcode});
+    }
+    if (kind == "addr") {
+        return parse_range(argument, {.field = Trigger::Field::Address});
+    }
+
+    if (kind == "signals") {
+        const auto slash = argument.find('/');
+        const auto value = parse_hex(argument.substr(0, slash));
+        const auto mask = slash == std::string_view::npos ? std::nullopt : parse_hex(argument.substr(slash + 1));
+        if (!value || !mask) {
+            return std::nullopt;
+        }
+        return Trigger{.field = Trigger::Field::Signals, .low = *value & *mask, .high = *value & *mask, .mask = *mask};
+    }
+
+    if (kind == "signal") {
+        const auto equals = argument.find('=');
+        const auto name = argument.substr(0, equals);
+        const auto level = argument.substr(equals == std::string_view::npos ? argument.size() : equals + 1);
+        const auto it = std::ranges::find(signal_names, name);
+        if (it == signal_names.end() || (level != "0" && level != "1")) {
+            return std::nullopt;
+        }
+
+        const auto bit = uint64_t{1} << (it - signal_names.begin());
+        const auto value = level == "1" ? bit : uint64_t{0};
+        return Trigger{.field = Trigger::Field::Signals, .low = value, .high = value, .mask = bit};
+    }
+
+    return std::nullopt;
+}
+
+auto trace::parse_trigger_config(std::string_view config) -> std::optional<TriggerConfig> {
+    auto result = TriggerConfig{};
+    auto has_start = false;
+
+    while (!config.empty()) {
+        const auto space = config.find(' ');
+        const auto item = config.substr(0, space);
+        config = space == std::string_view::npos ? std::string_view{} : config.substr(space + 1);
+        if (item.empty()) {
+            continue;
+        }
+
+        const auto equals = item.find('=');
+        if (equals == std::string_view::npos) {
+            return std::nullopt;
+        }
+        const auto key = item.substr(0, equals);
+        const auto value = item.substr(equals + 1);
+
+        if (key == "start" || key == "stop") {
+            const auto trigger = parse_trigger(value);
+            if (!trigger) {
+                return std::nullopt;
+            }
+            if (key == "start") {
+                result.start = *trigger;
+                has_start = true;
+            } else {
+                result.stop = trigger;
+            }
+            continue;
+        }
+
+        auto cycles = std::size_t{0};
+        const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), cycles);
+        if (error != std::errc{} || end != value.data() + value.size()) {
+            return std::nullopt;
+        }
+
+        if (key == "pre") {
+            result.pre_cycles = cycles;
+        } else if (key == "post") {
+            result.post_cycles = cycles;
+        } else if (key == "max") {
+            result.max_cycles = cycles;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    if (!has_start) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+trace::TriggeredRecorder::TriggeredRecorder(std::string name, TriggerConfig config, std::string path_prefix)
+    : on_capture([this, path_prefix = std::move(path_prefix)](const CpuRecorder &window) {
+          const auto path = path_prefix + "_" + std::to_string(finished) + ".fst";
+          if (write_fst(path, window)) {
+              fmt::println("trace window written to {}", path);
+          }
+      }),
+      recorder(std::move(name), config.pre_cycles + config.max_cycles + config.post_cycles), config(config) {}
+
+void trace::TriggeredRecorder::record(const CpuSample &sample) {
+    // the first sample with REG_IR_LOAD is the fetch, the opcode is on the bus and the PC still points at it
+    const auto ir_load = ((sample.signals >> ir_load_bit) & 1u) != 0u;
+    const auto fetch = ir_load && !last_ir_load;
+    last_ir_load = ir_load;
+
+    recorder.record(sample);
+
+    switch (state) {
+    case State::Armed:
+        if (config.start.matches(sample, fetch)) {
+            const auto pre = 2u * config.pre_cycles;
+            recorder.first_time = sample.time > pre ? sample.time - pre : 0u;
+            remaining = 2u * config.max_cycles;
+            state = State::Capturing;
+            if (!config.stop) {
+                start_post();
+            }
+        }
+        break;
+
+    case State::Capturing:
+        if (config.stop->matches(sample, fetch) || --remaining == 0u) {
+            start_post();
+        }
+        break;
+
+    case State::Post:
+        if (--remaining == 0u) {
+            finish();
+        }
+        break;
+    }
+}
+
+void trace::TriggeredRecorder::start_post() {
+    state = State::Post;
+    remaining = 2u * config.post_cycles;
+    if (remaining == 0u) {
+        finish();
+    }
+}
+
+void trace::TriggeredRecorder::finish() {
+    if (on_capture) {
+        on_capture(recorder);
+    }
+    finished++;
+    state = State::Armed;
+}
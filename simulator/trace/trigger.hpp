@@ -0,0 +1,106 @@
+#pragma once
+
+#include "trace.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Trigger-conditioned tracing: `TriggeredRecorder` keeps a short window of the CPU rolling and only writes it
+// when a trigger fires, so it can stay armed during full-speed runs.
+//
+// A trigger config is a space separated list, e.g. `start=signal:INT_ADDRESS_OUT=1 stop=opcode:f4 pre=32 post=16`
+// captures every interrupt from the ISR entry to its IRET
+//  start=COND, stop=COND  when to start and stop capturing, without `stop` the capture ends `post` cycles
+//                         after the start
+//  pre=N, post=N          cycles kept before the start and after the stop (default 32 each)
+//  max=N                  longest capture in cycles, a capture that gets longer is cut (default 4096)
+//
+// COND is one of
+//  pc:LOW[-HIGH]          address of a fetched instruction
+//  opcode:LOW[-HIGH]      fetched opcode
+//  addr:LOW[-HIGH]        address bus
+//  signal:NAME=0|1        a control signal, names as in cpu/include/signals.v
+//  signals:VALUE/MASK     all 48 control signals at once
+// all numbers are hex.
+
+namespace trace {
+    struct Trigger {
+        enum class Field : uint8_t { Pc, Opcode, Address, Signals };
+
+        Field field = Field::Pc;
+        uint64_t low = 0u;
+        uint64_t high = 0u;
+        uint64_t mask = ~uint64_t{0};
+
+        // PC and opcode are only compared on instruction fetches
+        auto matches(const CpuSample &sample, bool fetch) const -> bool {
+            auto value = uint64_t{0};
+            switch (field) {
+            case Field::Pc:
+                if (!fetch) {
+                    return false;
+                }
+                value = sample.pc;
+                break;
+            case Field::Opcode:
+                if (!fetch) {
+                    return false;
+                }
+                value = sample.bus;
+                break;
+            case Field::Address:
+                value = sample.addr_bus;
+                break;
+            case Field::Signals:
+                value = sample.signals;
+                break;
+            }
+            value &= mask;
+            return low <= value && value <= high;
+        }
+    };
+
+    struct TriggerConfig {
+        Trigger start{};
+        std::optional<Trigger> stop{};
+        std::size_t pre_cycles = 32u;
+        std::size_t post_cycles = 32u;
+        std::size_t max_cycles = 4096u;
+    };
+
+    auto parse_trigger(std::string_view condition) -> std::optional<Trigger>;
+    auto parse_trigger_config(std::string_view config) -> std::optional<TriggerConfig>;
+
+    struct TriggeredRecorder {
+        // Every finished capture is passed to `on_capture`, by default it is written to `<path_prefix>_<n>.fst`
+        TriggeredRecorder(std::string name, TriggerConfig config, std::string path_prefix);
+
+        // the default `on_capture` refers back to the recorder
+        TriggeredRecorder(const TriggeredRecorder &) = delete;
+        auto operator=(const TriggeredRecorder &) -> TriggeredRecorder & = delete;
+
+        template <typename Cpu> void capture(const Cpu &cpu) { record(sample_of(cpu, recorder.time)); }
+        void record(const CpuSample &sample);
+
+        auto is_capturing() const -> bool { return state != State::Armed; }
+        auto captures() const -> std::size_t { return finished; }
+
+        std::function<void(const CpuRecorder &)> on_capture;
+
+      private:
+        enum class State : uint8_t { Armed, Capturing, Post };
+
+        void start_post();
+        void finish();
+
+        CpuRecorder recorder;
+        TriggerConfig config;
+        State state = State::Armed;
+        bool last_ir_load = false;
+        std::size_t remaining = 0u;
+        std::size_t finished = 0u;
+    };
+}
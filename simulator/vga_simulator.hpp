@@ -1,59 +1,54 @@
 #pragma once
 #include "clockable_module.hpp"
+#include "perf_counters.hpp"
+#include "sync_checker.hpp"
 #include <Vmonitor_tester.h>
 #include <Vgpu.h>
+#include <Vgpu___024root.h>
 #include <cstdint>
 #include <imgui.h>
 #include <raylib.h>
 #include <fmt/format.h>
 #include <expected.hpp>
+#include <array>
+#include <concepts>
 #include <functional>
-
-// VGA timing (based on http://www.tinyvga.com/vga-timing/640x480@60Hz)
-
-constexpr static uint32_t h_visible_area = 640u;
-constexpr static uint32_t v_visible_area = 480u;
-constexpr static uint32_t h_front_porch = 16u;
-constexpr static uint32_t v_front_porch = 10u;
-constexpr static uint32_t h_sync_pulse_width = 96u;
-constexpr static uint32_t v_sync_pulse_width = 2u;
-constexpr static uint32_t h_back_porch = 48u;
-constexpr static uint32_t v_back_porch = 33u;
-constexpr static uint32_t h_total = h_front_porch + h_visible_area + h_sync_pulse_width + h_back_porch;
-constexpr static uint32_t v_total = v_front_porch + v_visible_area + v_sync_pulse_width + v_back_porch;
-
-// Simulator error types
-struct HSyncUndetected { auto message() const { return "Hsync undetected"; } };
-struct VSyncUndetected { auto message() const { return "Vsync undetected"; } };
-struct MultiplePulsesDetected {
-    bool is_hsync;
-    auto message() const { return fmt::format("Multiple {} pulses detected", is_hsync ? "hsync" : "vsync"); }
-};
-struct IncorrectPulseWidth {
-    bool is_hsync;
-    uint32_t expected;
-    uint32_t actual;
-    auto message() const { return fmt::format("Incorrect {} sync pulse width, expected: {}, found {}",  is_hsync ? "hsync" : "vsync", expected, actual); }
-};
-struct IncorrectSyncTiming {
-    bool is_hsync;
-    uint32_t expected;
-    uint32_t actual;
-    auto message() const { return fmt::format("{} expected on pulse {}, found on: {}", is_hsync ? "hsync" : "vsync", expected, actual); }
-};
-struct IncorrectRowTiming {
-    uint32_t row;
-    auto message() const { return fmt::format("Incorrect row timing on row {}", row); }
+#include <optional>
+
+// The timing of the GPU, the default profile
+constexpr static uint32_t h_visible_area = vga_timing::vga_640x480.h_visible_area;
+constexpr static uint32_t v_visible_area = vga_timing::vga_640x480.v_visible_area;
+constexpr static uint32_t h_front_porch = vga_timing::vga_640x480.h_front_porch;
+constexpr static uint32_t v_front_porch = vga_timing::vga_640x480.v_front_porch;
+constexpr static uint32_t h_sync_pulse_width = vga_timing::vga_640x480.h_sync_pulse_width;
+constexpr static uint32_t v_sync_pulse_width = vga_timing::vga_640x480.v_sync_pulse_width;
+constexpr static uint32_t h_back_porch = vga_timing::vga_640x480.h_back_porch;
+constexpr static uint32_t v_back_porch = vga_timing::vga_640x480.v_back_porch;
+constexpr static uint32_t h_total = vga_timing::vga_640x480.h_total();
+constexpr static uint32_t v_total = vga_timing::vga_640x480.v_total();
+
+// State of a driver's timing generator, regions encoded as the `Region` enum in gpu.sv
+struct VGAPosition {
+    enum Region : uint8_t { FrontPorch = 0, Sync = 1, BackPorch = 2, Display = 3 };
+
+    uint8_t h_region;
+    uint32_t h_counter;
+    uint8_t v_region;
+    uint32_t v_counter;
+
+    auto operator==(const VGAPosition &) const -> bool = default;
 };
 
-using VGASimulatorError = std::variant<
-    HSyncUndetected,
-    VSyncUndetected,
-    MultiplePulsesDetected,
-    IncorrectPulseWidth,
-    IncorrectSyncTiming,
-    IncorrectRowTiming
->;
+inline auto vga_position(const Vgpu &gpu) -> VGAPosition {
+    const auto *root = gpu.rootp;
+    return {root->gpu__DOT__h_region, root->gpu__DOT__h_counter, root->gpu__DOT__v_region, root->gpu__DOT__v_counter};
+}
+
+// Drivers that provide `vga_position` are synced analytically, the others by scanning for sync pulses
+template <typename T>
+concept ExposesVGAPosition = requires(const T &module) {
+    { vga_position(module) } -> std::same_as<VGAPosition>;
+};
 
 template <typename T>
 concept VerilatedVGADriver = ClockableModule<T> && requires(T module) {
@@ -64,10 +59,16 @@ concept VerilatedVGADriver = ClockableModule<T> && requires(T module) {
     module.vsync;
 };
 
-template <VerilatedVGADriver T>
+template <VerilatedVGADriver T, VGATiming Timing = vga_timing::vga_640x480>
 struct VGASimulator {
+    constexpr static auto timing = Timing;
+
     T* vga_driver;
     ClockScheduler* scheduler;
+    // Checks the timing of the frames read by `process_vga_frame`, counts every violation since the last `sync()`
+    SyncChecker<Timing> sync_checker{};
+    // Hardware counters for the capture path (the clock domains' evals are counted separately)
+    perf::CounterGroup* perf_group = nullptr;
 
     using DrawFunction = std::function<void(const uint32_t x, const uint32_t y, const Color color)>;
 
@@ -75,63 +76,95 @@ struct VGASimulator {
         : vga_driver(vga_driver), scheduler(scheduler), current_row(0) {}
 
     // it assumes that the monitor and the simulator are synced up - the module is assumed to be in display time
-    // run `sync()` before this
+    // run `sync()` before this. The whole frame is always read, when it's checked (see `sync_checker.validation`)
+    // the first timing violation in it is returned.
     auto process_vga_frame(DrawFunction draw_function) -> rd::expected<void, VGASimulatorError> {
         current_row = 0;
 
-        VSyncInfo vsync_info{};
-
-        bool is_in_visible_area{};
+        const auto checked = sync_checker.begin_frame();
 
-        while (current_row <= v_total) {
-            is_in_visible_area = current_row < v_visible_area;
-            if (const auto correct_row = process_vga_row(draw_function, is_in_visible_area) ; !correct_row) {
-                return rd::unexpected{correct_row.error()};
+        while (current_row <= timing.v_total()) {
+            const bool is_in_visible_area = current_row < timing.v_visible_area;
+            if (checked) {
+                process_vga_row<true>(draw_function, is_in_visible_area);
+            } else {
+                process_vga_row<false>(draw_function, is_in_visible_area);
             }
-
-            detect_sync_pulse_change(vsync_info, vga_driver->vsync, current_row);
             current_row++;
         }
 
-        if (!vsync_info.sync_detected) {
-            return rd::unexpected(VSyncUndetected{});
+        if (checked) {
+            if (const auto error = sync_checker.end_frame()) {
+                return rd::unexpected(*error);
+            }
         }
 
-        if (vsync_info.multiple_pulses_detected) {
-            return rd::unexpected(MultiplePulsesDetected{.is_hsync = false});
-        }
+        return {};
+    }
 
-        if (vsync_info.get_pulse_length() != v_sync_pulse_width) {
-            return rd::unexpected(IncorrectPulseWidth{
-                .is_hsync = false,
-                .expected = vsync_info.get_pulse_length(),
-                .actual = v_sync_pulse_width,
-            });
+    // If this function succeeds, the `process_vga_frame` function should generate correct frames
+    auto sync() -> rd::expected<void, VGASimulatorError> {
+        sync_checker.reset();
+        if constexpr (ExposesVGAPosition<T>) {
+            if (const auto ticks = ticks_to_frame_start(vga_position(*vga_driver))) {
+                for (auto i = uint64_t{0}; i < *ticks; i++) {
+                    scheduler->advance();
+                }
+                return {};
+            }
         }
+        return sync_by_edges();
+    }
 
-        if (vsync_info.sync_start != v_visible_area + v_front_porch) {
-            return rd::unexpected(IncorrectSyncTiming{
-                .is_hsync = false,
-                .expected = v_visible_area + v_front_porch,
-                .actual = vsync_info.sync_start
-            });
+    // Ticks until the driver is where `sync` leaves it: in the first tick of the visible area, both horizontally and
+    // vertically. nullopt for a position the timing generator can't be in.
+    //
+    // A line is counted from the tick the driver enters the horizontal sync, that's when the vertical state changes.
+    // gpu.sv shows one line more than the visible area (its v_counter goes up to 480), `process_vga_frame` reads
+    // that line as well.
+    static auto ticks_to_frame_start(const VGAPosition &position) -> std::optional<uint64_t> {
+        constexpr auto line = uint64_t{timing.h_total()};
+        constexpr auto frame = line * (timing.v_total() + 1u);
+        constexpr auto h_sync = timing.h_sync_pulse_width;
+        constexpr auto h_start = std::array<uint32_t, 4>{
+            h_sync + timing.h_back_porch + timing.h_visible_area, 0u, h_sync, h_sync + timing.h_back_porch};
+        constexpr auto h_length = std::array<uint32_t, 4>{
+            timing.h_front_porch, timing.h_sync_pulse_width, timing.h_back_porch, timing.h_visible_area};
+        constexpr auto v_display = timing.v_visible_area + 1u;
+        constexpr auto v_start = std::array<uint32_t, 4>{
+            v_display, v_display + timing.v_front_porch, v_display + timing.v_front_porch + timing.v_sync_pulse_width,
+            0u};
+        constexpr auto v_length = std::array<uint32_t, 4>{
+            timing.v_front_porch, timing.v_sync_pulse_width, timing.v_back_porch, v_display};
+
+        if (position.h_region > 3u || position.v_region > 3u || position.h_counter >= h_length[position.h_region] ||
+            position.v_counter >= v_length[position.v_region]) {
+            return std::nullopt;
         }
 
-        return {};
+        const auto now = (v_start[position.v_region] + position.v_counter) * line + h_start[position.h_region] + position.h_counter;
+        const auto target = uint64_t{h_start[VGAPosition::Display]};
+        return (target + frame - now) % frame;
     }
 
-    // If this function succeeds, the `process_vga_frame` function should generate correct frames
-    auto sync() -> rd::expected<void, VGASimulatorError> {
-        static constexpr auto max_pulses = h_total * v_total * 5;
+    // Finds the frame start from the hsync and vsync pulses, works for every driver and checks the sync timing on the
+    // way. Takes up to a few frames.
+    auto sync_by_edges() -> rd::expected<void, VGASimulatorError> {
+        static constexpr auto max_pulses = timing.h_total() * timing.v_total() * 5;
         auto i = 0u;
 
-        // first we find the hsync pulse + back porch (so we sync up with horizontal display time)
+        // first we find the hsync pulse + back porch (so we sync up with horizontal display time), a pulse that is
+        // already going can't be measured so it's skipped (Monitor_Tester starts in one)
+        do {
+            scheduler->advance();
+        } while (hsync_asserted() && ++i < max_pulses);
+
         HSyncInfo hsync_info{};
 
         while(i < max_pulses) {
             scheduler->advance();
 
-            if(detect_sync_pulse_change(hsync_info, vga_driver->hsync, i) && !hsync_info.is_in_sync_pulse) {
+            if(detect_sync_pulse_change(hsync_info, hsync_asserted(), i) && !hsync_info.is_in_sync_pulse) {
                 break;
             }
             i++;
@@ -145,29 +178,30 @@ struct VGASimulator {
             return rd::unexpected(MultiplePulsesDetected{.is_hsync = true});
         }
 
-        if (hsync_info.get_pulse_length() != h_sync_pulse_width) {
+        if (hsync_info.get_pulse_length() != timing.h_sync_pulse_width) {
             return rd::unexpected(IncorrectPulseWidth{
                 .is_hsync = true,
-                .expected = h_sync_pulse_width,
+                .expected = timing.h_sync_pulse_width,
                 .actual = hsync_info.get_pulse_length()
             });
         }
 
-        for (auto j = 0u; j < h_back_porch; j++) {
+        for (auto j = 0u; j < timing.h_back_porch; j++) {
             scheduler->advance();
         }
 
-        // then the same for vsync
+        // then the same for vsync, the lines themselves are checked once the frames are read
         VSyncInfo vsync_info{};
 
         i = 0u;
+        do {
+            process_vga_row<false>([](const uint32_t, const uint32_t, const Color){}, false);
+        } while (vsync_asserted() && ++i < max_pulses);
+
         while (i < max_pulses) {
-            if (const auto correct_row = process_vga_row([](const uint32_t, const uint32_t, const Color){}, false) ; !correct_row) {
-                i += h_total;
-                return rd::unexpected{correct_row.error()};
-            }
+            process_vga_row<false>([](const uint32_t, const uint32_t, const Color){}, false);
 
-            if(detect_sync_pulse_change(vsync_info, vga_driver->vsync, current_row) && !vsync_info.is_in_sync_pulse) {
+            if(detect_sync_pulse_change(vsync_info, vsync_asserted(), i) && !vsync_info.is_in_sync_pulse) {
                 break;
             }
             i++;
@@ -181,11 +215,8 @@ struct VGASimulator {
             return rd::unexpected(MultiplePulsesDetected{.is_hsync = false});
         }
 
-        for (auto j = 0u; j < v_back_porch; j++) {
-            if (!process_vga_row([](const uint32_t, const uint32_t, const Color){}, false)) {
-                fmt::println("Incorrect row timing on row {}", current_row);
-                i += h_total;
-            }
+        for (auto j = 0u; j < timing.v_back_porch; j++) {
+            process_vga_row<false>([](const uint32_t, const uint32_t, const Color){}, false);
         }
 
         return {};
@@ -196,18 +227,19 @@ private:
     bool is_in_sync = false;
 
     // it assumes that the monitor and the simulator are synced up - the module is assumed to be in display time
-    auto process_vga_row(DrawFunction draw_function, bool is_in_vertical_visible_area) -> rd::expected<void, VGASimulatorError> {
-        uint32_t current_col = 0;
-
-        HSyncInfo hsync_info{};
+    template <bool Checked> void process_vga_row(const DrawFunction &draw_function, bool is_in_vertical_visible_area) {
+        PROFILE_SCOPE(profiler::zones.vga_row);
+        const perf::ScopedGroup perf_scope{perf_group};
 
         // Process one complete horizontal line
-        while (current_col < h_total) {
+        for (uint32_t current_col = 0; current_col < timing.h_total(); current_col++) {
             scheduler->advance();
 
-            detect_sync_pulse_change(hsync_info, vga_driver->hsync, current_col);
+            if constexpr (Checked) {
+                sync_checker.sample(hsync_asserted(), vsync_asserted());
+            }
 
-            if (is_in_vertical_visible_area && current_col < h_visible_area) {
+            if (is_in_vertical_visible_area && current_col < timing.h_visible_area) {
                 Color color = {
                     static_cast<unsigned char>(vga_driver->red * 16),
                     static_cast<unsigned char>(vga_driver->green * 16),
@@ -215,38 +247,10 @@ private:
                     255
                 };
 
+                PROFILE_SCOPE(profiler::zones.draw_callback);
                 draw_function(current_col, current_row, color);
             }
-
-            current_col++;
         }
-
-        if (!hsync_info.sync_detected) {
-            return rd::unexpected(HSyncUndetected{});
-        }
-
-        if (hsync_info.multiple_pulses_detected) {
-            return rd::unexpected(MultiplePulsesDetected{.is_hsync = true});
-        }
-
-        if (hsync_info.get_pulse_length() != h_sync_pulse_width) {
-            return rd::unexpected(IncorrectPulseWidth{
-                .is_hsync = true,
-                .expected = h_sync_pulse_width,
-                .actual = hsync_info.get_pulse_length()
-            });
-        }
-
-        // TODO: Find out why we need the -1 here (????)
-        if (hsync_info.sync_start != h_visible_area + h_front_porch - 1) {
-            return rd::unexpected(IncorrectSyncTiming{
-                .is_hsync = true,
-                .expected = hsync_info.sync_start,
-                .actual = h_visible_area + h_front_porch
-            });
-        }
-
-        return {};
     }
 
     struct SignalSyncInfo {
@@ -261,7 +265,9 @@ private:
         }
     };
 
-    // TODO: Check vsync and hsync polarity (whether it should be high or low during sync pulse)
+    auto hsync_asserted() const -> bool { return static_cast<bool>(vga_driver->hsync) == timing.hsync_active_high; }
+    auto vsync_asserted() const -> bool { return static_cast<bool>(vga_driver->vsync) == timing.vsync_active_high; }
+
     bool detect_sync_pulse_change(SignalSyncInfo& info, bool sync_signal, uint32_t position) {
         bool state_changed = false;
 
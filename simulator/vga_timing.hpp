@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <fmt/format.h>
+#include <variant>
+
+// VGA timing profiles, `VGASimulator` takes one as a template parameter so its row and frame loops are specialized
+// for it (based on http://www.tinyvga.com/vga-timing)
+struct VGATiming {
+    uint32_t h_visible_area;
+    uint32_t h_front_porch;
+    uint32_t h_sync_pulse_width;
+    uint32_t h_back_porch;
+    uint32_t v_visible_area;
+    uint32_t v_front_porch;
+    uint32_t v_sync_pulse_width;
+    uint32_t v_back_porch;
+    // level of the sync signals during the pulse
+    bool hsync_active_high;
+    bool vsync_active_high;
+
+    constexpr auto h_total() const -> uint32_t {
+        return h_front_porch + h_visible_area + h_sync_pulse_width + h_back_porch;
+    }
+    constexpr auto v_total() const -> uint32_t {
+        return v_front_porch + v_visible_area + v_sync_pulse_width + v_back_porch;
+    }
+};
+
+namespace vga_timing {
+    // 640x480@60Hz, the standard pulses are active low but gpu.sv drives them active high
+    constexpr auto vga_640x480 = VGATiming{640u, 16u, 96u, 48u, 480u, 10u, 2u, 33u, true, true};
+    // 800x600@60Hz
+    constexpr auto svga_800x600 = VGATiming{800u, 40u, 128u, 88u, 600u, 1u, 4u, 23u, true, true};
+    // 1024x768@60Hz
+    constexpr auto xga_1024x768 = VGATiming{1024u, 24u, 136u, 160u, 768u, 3u, 6u, 29u, false, false};
+}
+
+// Simulator error types
+struct HSyncUndetected { auto message() const { return "Hsync undetected"; } };
+struct VSyncUndetected { auto message() const { return "Vsync undetected"; } };
+struct MultiplePulsesDetected {
+    bool is_hsync;
+    auto message() const { return fmt::format("Multiple {} pulses detected", is_hsync ? "hsync" : "vsync"); }
+};
+struct IncorrectPulseWidth {
+    bool is_hsync;
+    uint32_t expected;
+    uint32_t actual;
+    auto message() const { return fmt::format("Incorrect {} sync pulse width, expected: {}, found {}",  is_hsync ? "hsync" : "vsync", expected, actual); }
+};
+struct IncorrectSyncTiming {
+    bool is_hsync;
+    uint32_t expected;
+    uint32_t actual;
+    auto message() const { return fmt::format("{} expected on pulse {}, found on: {}", is_hsync ? "hsync" : "vsync", expected, actual); }
+};
+struct IncorrectRowTiming {
+    uint32_t row;
+    auto message() const { return fmt::format("Incorrect row timing on row {}", row); }
+};
+
+using VGASimulatorError = std::variant<
+    HSyncUndetected,
+    VSyncUndetected,
+    MultiplePulsesDetected,
+    IncorrectPulseWidth,
+    IncorrectSyncTiming,
+    IncorrectRowTiming
+>;
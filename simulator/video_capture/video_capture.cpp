@@ -0,0 +1,213 @@
+#include "video_capture.hpp"
+#include <array>
+#include <chrono>
+
+namespace {
+    void put_varint(uint64_t value, std::vector<uint8_t> &out) {
+        while (value >= 0x80u) {
+            out.push_back(static_cast<uint8_t>(value | 0x80u));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    auto get_varint(const std::vector<uint8_t> &in, std::size_t &pos) -> std::optional<uint64_t> {
+        auto value = uint64_t{0};
+        for (auto shift = 0u; shift < 64u; shift += 7u) {
+            if (pos >= in.size()) {
+                return std::nullopt;
+            }
+            const auto byte = in[pos++];
+            value |= static_cast<uint64_t>(byte & 0x7Fu) << shift;
+            if ((byte & 0x80u) == 0u) {
+                return value;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void put_u16(uint16_t value, std::vector<uint8_t> &out) {
+        out.push_back(static_cast<uint8_t>(value));
+        out.push_back(static_cast<uint8_t>(value >> 8u));
+    }
+
+    auto get_u16(const std::vector<uint8_t> &in, std::size_t &pos) -> std::optional<uint16_t> {
+        if (pos + 2u > in.size()) {
+            return std::nullopt;
+        }
+        const auto value = static_cast<uint16_t>(in[pos] | in[pos + 1u] << 8u);
+        pos += 2u;
+        return value;
+    }
+}
+
+void video_capture::encode_frame(const uint16_t *pixels, std::size_t count, std::vector<uint8_t> &out) {
+    for (auto i = std::size_t{0}; i < count;) {
+        const auto color = pixels[i];
+        auto end = i + 1u;
+        while (end < count && pixels[end] == color) {
+            end++;
+        }
+        put_varint(end - i, out);
+        put_u16(color, out);
+        i = end;
+    }
+}
+
+video_capture::Writer::Writer(const std::string &path, uint16_t width, uint16_t height, Policy policy)
+    : file(record_file::create(path, file_magic)), frame_size(std::size_t{width} * height), policy(policy),
+      buffers(buffer_count * frame_size) {
+    if (file == nullptr) {
+        return;
+    }
+
+    for (auto i = 0u; i < buffer_count; i++) {
+        free_buffers.push(i);
+    }
+
+    auto header = std::vector<uint8_t>{};
+    put_u16(width, header);
+    put_u16(height, header);
+    std::fwrite(header.data(), 1, header.size(), file);
+    thread = std::thread{[this] { run(); }};
+}
+
+video_capture::Writer::~Writer() {
+    if (file == nullptr) {
+        return;
+    }
+
+    stop.store(true, std::memory_order_release);
+    thread.join();
+    std::fclose(file);
+}
+
+auto video_capture::Writer::begin_frame() -> uint16_t * {
+    current = free_buffers.pop();
+    while (!current && policy == Policy::Wait && file != nullptr) {
+        std::this_thread::yield();
+        current = free_buffers.pop();
+    }
+    return current ? buffers.data() + *current * frame_size : nullptr;
+}
+
+void video_capture::Writer::end_frame() {
+    const auto frame = next_frame++;
+    if (!current) {
+        dropped_frames++;
+        last_dropped = true;
+        return;
+    }
+
+    submit({frame, *current, FrameKind::Pixels});
+    current.reset();
+}
+
+void video_capture::Writer::repeat_frame() {
+    const auto frame = next_frame++;
+    // the frame it repeats isn't in the file
+    if (last_dropped || file == nullptr) {
+        dropped_frames++;
+        last_dropped = true;
+        return;
+    }
+    submit({frame, 0u, FrameKind::Repeat});
+}
+
+void video_capture::Writer::submit(const Entry &entry) {
+    // only repeats can find `ready` full, there are fewer buffers than it holds
+    while (!ready.push(entry)) {
+        if (policy == Policy::Drop) {
+            dropped_frames++;
+            last_dropped = true;
+            return;
+        }
+        std::this_thread::yield();
+    }
+    last_dropped = false;
+}
+
+void video_capture::Writer::run() {
+    auto previous_frame = ~uint64_t{0};
+    auto encoded = std::vector<uint8_t>{};
+
+    const auto drain = [&] {
+        auto count = 0u;
+        while (const auto entry = ready.pop()) {
+            encoded.clear();
+            put_varint(entry->frame - previous_frame, encoded);
+            encoded.push_back(static_cast<uint8_t>(entry->kind));
+            if (entry->kind == FrameKind::Pixels) {
+                encode_frame(buffers.data() + entry->buffer * frame_size, frame_size, encoded);
+                free_buffers.push(entry->buffer);
+            }
+            std::fwrite(encoded.data(), 1, encoded.size(), file);
+
+            previous_frame = entry->frame;
+            written_frames.fetch_add(1u, std::memory_order_relaxed);
+            count++;
+        }
+        return count;
+    };
+
+    while (!stop.load(std::memory_order_acquire)) {
+        if (drain() == 0u) {
+            std::this_thread::sleep_for(std::chrono::microseconds{200});
+        }
+    }
+
+    // everything submitted before the destructor was called
+    drain();
+}
+
+auto video_capture::read(const std::string &path) -> std::optional<Video> {
+    const auto contents = record_file::read_file(path, file_magic);
+    if (!contents) {
+        return std::nullopt;
+    }
+    const auto &bytes = *contents;
+
+    auto pos = std::size_t{0};
+    const auto width = get_u16(bytes, pos);
+    const auto height = get_u16(bytes, pos);
+    if (!width || !height) {
+        return std::nullopt;
+    }
+
+    auto video = Video{.width = *width, .height = *height, .frames = {}};
+    const auto frame_size = std::size_t{*width} * *height;
+    auto previous_frame = ~uint64_t{0};
+
+    while (pos < bytes.size()) {
+        const auto delta = get_varint(bytes, pos);
+        if (!delta || pos >= bytes.size()) {
+            return std::nullopt;
+        }
+        const auto kind = static_cast<FrameKind>(bytes[pos++]);
+        auto frame = Frame{.index = previous_frame + *delta, .pixels = {}};
+
+        if (kind == FrameKind::Repeat) {
+            if (video.frames.empty()) {
+                return std::nullopt;
+            }
+            frame.pixels = video.frames.back().pixels;
+        } else if (kind == FrameKind::Pixels) {
+            frame.pixels.reserve(frame_size);
+            while (frame.pixels.size() < frame_size) {
+                const auto run = get_varint(bytes, pos);
+                const auto color = get_u16(bytes, pos);
+                if (!run || !color || *run > frame_size - frame.pixels.size()) {
+                    return std::nullopt;
+                }
+                frame.pixels.insert(frame.pixels.end(), *run, *color);
+            }
+        } else {
+            return std::nullopt;
+        }
+
+        previous_frame = frame.index;
+        video.frames.push_back(std::move(frame));
+    }
+
+    return video;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "record_file.hpp"
+#include "ring_buffer.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Lossless recording of simulated frames.
+//
+// The simulation draws into one of a few preallocated frame buffers and hands it to a background thread, which
+// run-length encodes and writes it. When all buffers are still being encoded the `Policy` decides whether the
+// simulation waits or the frame is dropped. On disk, after `file_magic` and the width and height (u16 each):
+//
+//   varint  frames since the previous record, more than 1 after dropped frames
+//   byte    `FrameKind`
+//   runs    for `Pixels`: varint run length and the u16 color, until the frame is covered
+//
+// Colors are the 4 bits per channel the VGA drivers output, see `pack`. All numbers are little endian.
+// tools/video_to_y4m.py converts a recording for ffmpeg and video players.
+
+namespace video_capture {
+    enum class Policy : uint8_t {
+        Wait, // the simulation waits for a free buffer, no frame is lost
+        Drop, // frames without a free buffer are dropped, the simulation never waits
+    };
+
+    enum class FrameKind : uint8_t {
+        Pixels = 0,
+        Repeat = 1, // the same as the previous record
+    };
+
+    constexpr static char file_magic[8] = {'V', 'I', 'D', 'C', 'A', 'P', '0', '1'};
+
+    // 0x0RGB from the 8 bit channels `VGASimulator` draws with
+    constexpr auto pack(uint8_t red, uint8_t green, uint8_t blue) -> uint16_t {
+        return static_cast<uint16_t>((red >> 4u) << 8u | (green >> 4u) << 4u | blue >> 4u);
+    }
+
+    // Appends the runs of a frame to `out`
+    void encode_frame(const uint16_t *pixels, std::size_t count, std::vector<uint8_t> &out);
+
+    struct Writer {
+        Writer(const std::string &path, uint16_t width, uint16_t height, Policy policy = Policy::Wait);
+        ~Writer();
+
+        Writer(const Writer &) = delete;
+        auto operator=(const Writer &) -> Writer & = delete;
+
+        auto is_open() const -> bool { return file != nullptr; }
+
+        // Buffer for the next frame, `width * height` pixels in rows. nullptr when the frame is dropped, `end_frame`
+        // has to be called either way.
+        auto begin_frame() -> uint16_t *;
+        void end_frame();
+
+        // The next frame is the same as the previous one, it doesn't take a buffer
+        void repeat_frame();
+
+        auto frames() const -> uint64_t { return next_frame; }
+        auto dropped() const -> uint64_t { return dropped_frames; }
+        auto written() const -> uint64_t { return written_frames.load(std::memory_order_relaxed); }
+
+      private:
+        constexpr static std::size_t buffer_count = 8u;
+
+        struct Entry {
+            uint64_t frame;
+            uint32_t buffer;
+            FrameKind kind;
+        };
+
+        void submit(const Entry &entry);
+        void run();
+
+        std::FILE *file;
+        std::size_t frame_size;
+        Policy policy;
+        std::vector<uint16_t> buffers;
+        // indices into `buffers`, the encoder gives them back through `free_buffers`
+        RingBuffer<uint32_t, buffer_count> free_buffers{};
+        RingBuffer<Entry, 2u * buffer_count> ready{};
+        std::optional<uint32_t> current{};
+        uint64_t next_frame = 0u;
+        uint64_t dropped_frames = 0u;
+        bool last_dropped = false;
+        std::atomic<bool> stop{false};
+        std::atomic<uint64_t> written_frames{0u};
+        std::thread thread;
+    };
+
+    struct Frame {
+        uint64_t index;
+        std::vector<uint16_t> pixels;
+    };
+
+    struct Video {
+        uint16_t width;
+        uint16_t height;
+        std::vector<Frame> frames;
+    };
+
+    // Reads a whole recording, returns nullopt when the file is missing, not a recording or truncated
+    auto read(const std::string &path) -> std::optional<Video>;
+}
@@ -0,0 +1,156 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+#include "Vcpu.h"
+#include "Vcpu___024root.h"
+#include "Vcpu_mux.h"
+#include "Vcpu_mux___024root.h"
+#include "cpu_system.hpp"
+#include "trace_on_failure.hpp"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Checks that the MUX_BUSES build of the CPU behaves exactly like the tristate build,
+// both CPUs run the programs of cpu_test (with the nop and halt opcodes fixed) in lockstep, each with its own memory.
+// A failing test writes the last 64 cycles of both CPUs to `<test name>.fst`.
+
+constexpr size_t trace_cycles = 64;
+
+void check_same_state(const System<Vcpu> &tristate, const System<Vcpu_mux> &mux, size_t cycle) {
+    INFO("half cycle ", cycle);
+
+    CHECK_EQ(tristate.cpu.zero_page, mux.cpu.zero_page);
+    CHECK_EQ(tristate.cpu.mem_part, mux.cpu.mem_part);
+    CHECK_EQ(tristate.cpu.mem_out, mux.cpu.mem_out);
+    CHECK_EQ(tristate.cpu.mem_in, mux.cpu.mem_in);
+    CHECK_EQ(tristate.cpu.reg_mbr_load, mux.cpu.reg_mbr_load);
+    CHECK_EQ(tristate.cpu.reg_mbr_word_dir, mux.cpu.reg_mbr_word_dir);
+    CHECK_EQ(tristate.cpu.reg_mar_load, mux.cpu.reg_mar_load);
+    CHECK_EQ(tristate.cpu.int_bus, mux.cpu.int_bus);
+    CHECK_EQ(tristate.a(), mux.a());
+    CHECK_EQ(tristate.b(), mux.b());
+    CHECK_EQ(tristate.pc(), mux.pc());
+
+    // buses are only compared while somebody is listening, an undriven bus is don't care
+    if (tristate.cpu.reg_mar_load) {
+        CHECK_EQ(tristate.cpu.addr_bus, mux.cpu.addr_bus);
+    }
+    if (tristate.cpu.reg_mbr_word_dir && tristate.cpu.mem_out) {
+        CHECK_EQ(tristate.cpu.bus_out, mux.cpu.bus_out);
+    }
+}
+
+TEST_CASE("Mov program matches the tristate build") {
+    System<Vcpu> tristate;
+    System<Vcpu_mux> mux;
+
+    const uint8_t prog[] = {
+        0x11, 0x05,       // mov a, 0x05
+        0x05,             // mov b, a
+        0x0A,             // mov th, b
+        0x0D,             // mov tl, a
+        0x02,             // mov a, th
+        0x07,             // mov b, tl
+        0x01,             // mov a, b
+        0x19, 0xDE, 0xAD, // mov [0xDEAD], a
+        0x19, 0xBE, 0xEF, // mov [0xBEEF], a
+        0x11, 0x33,       // mov a, 0x33
+        0x19, 0xCA, 0xFE, // mov [0xCAFE], a
+        0xFA              // halt
+    };
+
+    tristate.store(0x0000, prog);
+    mux.store(0x0000, prog);
+
+    auto tristate_trace = trace::CpuRecorder{"tristate", trace_cycles};
+    auto mux_trace = trace::CpuRecorder{"mux", trace_cycles};
+    const auto traced = TraceOnFailure{&tristate_trace, &mux_trace};
+
+    for (size_t i = 0; i < 256; i++) {
+        tristate.half_cycle();
+        mux.half_cycle();
+        tristate_trace.capture(tristate.cpu);
+        mux_trace.capture(mux.cpu);
+        check_same_state(tristate, mux, i);
+    }
+
+    for (const uint16_t address : {0xDEAD, 0xBEEF, 0xCAFE}) {
+        CHECK_EQ(tristate.read(address), mux.read(address));
+    }
+}
+
+TEST_CASE("INT0 handling matches the tristate build") {
+    System<Vcpu> tristate;
+    System<Vcpu_mux> mux;
+
+    const uint8_t prog[] = {0xEF, 0xEF, 0xEF, 0xEF, 0xEF, 0xEF, 0xEF, 0xEF, 0xFA}; // nop x8, halt
+    const uint8_t isr0[] = {
+        0x11, 0x73,       // mov a, 0x73
+        0x19, 0xDE, 0xAD, // mov [0xDEAD], a
+        0xFA              // halt
+    };
+    const uint8_t isr0_vector[] = {0xA0, 0xB0};
+
+    tristate.store(0x0000, prog);
+    tristate.store(0xA0B0, isr0);
+    tristate.store(0xFFF2, isr0_vector);
+    mux.store(0x0000, prog);
+    mux.store(0xA0B0, isr0);
+    mux.store(0xFFF2, isr0_vector);
+
+    auto tristate_trace = trace::CpuRecorder{"tristate", trace_cycles};
+    auto mux_trace = trace::CpuRecorder{"mux", trace_cycles};
+    const auto traced = TraceOnFailure{&tristate_trace, &mux_trace};
+
+    for (size_t i = 0; i < 256; i++) {
+        if (i == 12) {
+            tristate.cpu.int_in = 0x01;
+            mux.cpu.int_in = 0x01;
+        }
+        tristate.half_cycle();
+        mux.half_cycle();
+        tristate_trace.capture(tristate.cpu);
+        mux_trace.capture(mux.cpu);
+        check_same_state(tristate, mux, i);
+    }
+
+    // only the equivalence, the microcode in resources/roms doesn't enter the ISR yet (see interrupts::check_roms
+    // and the interrupt test in cpu_test)
+    CHECK_EQ(tristate.read(0xDEAD), mux.read(0xDEAD));
+}
+
+struct Throughput {
+    double half_cycles_per_second;
+    uint16_t pc;
+};
+
+template <typename Cpu> auto measure_throughput(size_t half_cycles) -> Throughput {
+    System<Cpu> system;
+
+    // a nop is 4 microcode steps, 4 cycles or 8 half cycles, the sled outlasts the measured half cycles
+    constexpr uint8_t nop = 0xEF;
+    const auto nops = std::vector<uint8_t>(0xF000, nop);
+    system.store(0x0000, nops);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < half_cycles; i++) {
+        system.half_cycle();
+    }
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    return {static_cast<double>(half_cycles) / elapsed.count(), static_cast<uint16_t>(system.pc())};
+}
+
+TEST_CASE("Eval throughput of both builds") {
+    constexpr size_t half_cycles = 200000;
+
+    const auto tristate = measure_throughput<Vcpu>(half_cycles);
+    const auto mux = measure_throughput<Vcpu_mux>(half_cycles);
+
+    MESSAGE("tristate: ", tristate.half_cycles_per_second, " half cycles/s, mux: ", mux.half_cycles_per_second,
+            " half cycles/s, speedup: ", mux.half_cycles_per_second / tristate.half_cycles_per_second);
+    // both builds spent the measured time running the same nops
+    CHECK_EQ(tristate.pc, mux.pc);
+    CHECK_GT(mux.pc, half_cycles / 10u);
+    CHECK_LT(mux.pc, 0xF000u);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Vmem_unit.h"
+#include "mem_unit_helpers.hpp"
+#include "verilated.h"
+#include <cstdint>
+#include <memory>
+#include <span>
+
+// A CPU wired to its own Vmem_unit exactly like in cpu_test, `Cpu` is Vcpu or Vcpu_mux
+template <typename Cpu> struct System {
+    std::unique_ptr<VerilatedContext> ctx = std::make_unique<VerilatedContext>();
+    Vmem_unit mem;
+    Cpu cpu{ctx.get(), "cpu"};
+    bool clk = false;
+
+    System() {
+        reset(mem);
+        mem.eval();
+
+        cpu.clk = clk;
+        cpu.bus_in_en = 0;
+        cpu.bus_in = 0;
+        cpu.rst = 0;
+        cpu.int_in = 0x00;
+        cpu.eval();
+        clk = !clk;
+        cpu.clk = clk;
+        cpu.eval();
+
+        cpu.rst = 1;
+    }
+
+    void store(uint16_t address, std::span<const uint8_t> data) {
+        for (size_t i = 0; i < data.size(); i++) {
+            load_mar_mbr(mem, address + i, data[i]);
+            mem.eval();
+
+            load_mbr_to_mem(mem);
+            mem.eval();
+        }
+    }
+
+    auto read(uint16_t address) -> uint8_t {
+        load_mar_mbr(mem, address, 0x00);
+        mem.eval();
+
+        load_mem(mem);
+        mem.eval();
+        return mem.data_out;
+    }
+
+    void half_cycle() {
+        clk = !clk;
+        cpu.clk = clk;
+        cpu.eval();
+        mem.zero_page = cpu.zero_page;
+        mem.mem_part = cpu.mem_part;
+        mem.mem_in = cpu.mem_in;
+        mem.mem_out = cpu.mem_out;
+        mem.reg_mbr_load = cpu.reg_mbr_load & clk;
+        mem.reg_mbr_word_dir = cpu.reg_mbr_word_dir;
+        mem.reg_mar_load = cpu.reg_mar_load & clk;
+        mem.data_in_en = cpu.reg_mbr_load;
+        mem.data_in = cpu.bus_out;
+        mem.address = cpu.addr_bus;
+        mem.eval();
+        cpu.bus_in_en = (~mem.mem_out & 1);
+        cpu.bus_in = mem.data_out;
+        cpu.eval();
+    }
+
+    auto a() const { return cpu.rootp->cpu_adapter__DOT__cpu__DOT__a_out; }
+    auto b() const { return cpu.rootp->cpu_adapter__DOT__cpu__DOT__b_out; }
+    auto pc() const { return cpu.rootp->cpu_adapter__DOT__cpu__DOT__pc_out; }
+};
@@ -3,83 +3,19 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest/doctest.h"
 #include "Vcpu.h"
+#include "Vcpu___024root.h"
 #include "Vmem_unit.h"
+#include "cpu_system.hpp"
+#include "interrupts.hpp"
+#include "mem_unit_helpers.hpp"
+#include "trace_on_failure.hpp"
 #include "verilated.h"
 #include <iostream>
 #include <iomanip>
+#include <vector>
 
-enum ReadFlags {
-    READ_ZP = 1, // zero page
-    READ_HP = 2, // high part
-};
-
-enum WriteFlags {
-    WRITE_ZP = 1, // zero page
-    WRITE_HP = 2, // high part
-};
-
-void reset(Vmem_unit& mem) {
-    mem.zero_page = 1;
-    mem.mem_part = 0;
-    mem.mem_out = 1;
-    mem.mem_in = 1;
-    mem.reg_mbr_load = 0;
-    mem.reg_mar_load = 0;
-    mem.reg_mbr_word_dir = 1;
-    mem.data_in_en = 0;
-    //mem.reg_mbr_use_bus = 1;
-}
-
-void load_mar_mbr(Vmem_unit& mem, int addr, int data) {
-    mem.reg_mar_load = 1;
-    mem.reg_mbr_load = 1;
-    mem.mem_out = 1;
-    mem.mem_in = 1;
-    mem.mem_part = 0;
-    mem.zero_page = 1;
-    mem.reg_mbr_word_dir = 1;
-    mem.data_in = data;
-    mem.data_in_en = 1;
-    mem.address = addr;
-    //mem.reg_mbr_use_bus = 0;
-}
-
-void load_mbr_to_mem(Vmem_unit& mem, int flags = 0) {
-    mem.reg_mar_load = 0;
-    mem.reg_mbr_load = 0;
-    mem.mem_out = 1;
-    mem.mem_in = 0;
-    mem.mem_part = (flags & READ_HP) ? 1 : 0;
-    mem.zero_page = (flags & READ_ZP) ? 0 : 1;
-    mem.reg_mbr_word_dir = 1;
-    mem.data_in_en = 0;
-    //mem.reg_mbr_use_bus = 1;
-}
-
-void load_mem(Vmem_unit& mem, int flags = 0) {
-    mem.reg_mar_load = 0;
-    mem.reg_mbr_load = 0;
-    mem.mem_out = 0;
-    mem.mem_in = 1;
-    mem.mem_part = (flags & READ_HP) ? 1 : 0;
-    mem.zero_page = (flags & READ_ZP) ? 0 : 1;
-    mem.reg_mbr_word_dir = 0;
-    mem.data_in_en = 0;
-    //mem.reg_mbr_use_bus = 0;
-}
-
-void load_mar(Vmem_unit& mem, int addr) {
-    mem.reg_mar_load = 1;
-    mem.reg_mbr_load = 0;
-    mem.mem_out = 1;
-    mem.mem_in = 1;
-    mem.mem_part = 0;
-    mem.zero_page = 1;
-    mem.reg_mbr_word_dir = 1;
-    mem.address = addr;
-    mem.data_in_en = 0;
-    //mem.reg_mbr_use_bus = 0;
-}
+// A failing test writes the last 64 cycles of the CPU to `<test name>.fst`
+constexpr size_t trace_cycles = 64;
 
 TEST_CASE("Mov works") {
     VerilatedContext* ctx = new VerilatedContext;
@@ -133,6 +69,9 @@ TEST_CASE("Mov works") {
         mem.eval();
     }
 
+    auto recorder = trace::CpuRecorder{"cpu", trace_cycles};
+    const auto traced = TraceOnFailure{&recorder};
+
     for (size_t i = 0; i < 256; i++) {
         clk = !clk;
         cpu.clk = clk;
@@ -153,6 +92,7 @@ TEST_CASE("Mov works") {
         cpu.bus_in = mem.data_out;
         cpu.eval();
         ctx->timeInc(1);
+        recorder.capture(cpu);
     }
 
     load_mar_mbr(mem, 0xDEAD, 0x00);
@@ -251,6 +191,9 @@ TEST_CASE("Handling INT0 works") {
     load_mbr_to_mem(mem);
     mem.eval();
 
+    auto recorder = trace::CpuRecorder{"cpu", trace_cycles};
+    const auto traced = TraceOnFailure{&recorder};
+
     for (size_t i = 0; i < 256; i++) {
         if (i == 12) cpu.int_in = 0x01;
         clk = !clk;
@@ -272,6 +215,7 @@ TEST_CASE("Handling INT0 works") {
         cpu.bus_in = mem.data_out;
         cpu.eval();
         ctx->timeInc(1);
+        recorder.capture(cpu);
     }
 
     load_mar_mbr(mem, 0xDEAD, 0x00);
@@ -281,3 +225,44 @@ TEST_CASE("Handling INT0 works") {
     mem.eval();
     CHECK_MESSAGE(mem.data_out == 0x73, "read @ 0xDEAD");
 }
+
+// Skipped while interrupts::check_roms finds the microcode can't take INT0, see interrupts.hpp
+TEST_CASE("An interrupt enters its handler through the vector at 0xFFF2" *
+          doctest::skip(interrupts::check_roms(ROMS_DIR, *interrupts::parse_config("vsync=0")).has_value())) {
+    System<Vcpu> system;
+
+    const uint8_t nop = 0xEF;
+    const auto sled = std::vector<uint8_t>(0x100, nop);
+    const uint8_t loop[] = {0xB2, 0x00, 0x00}; // jmp 0x0000
+    const uint8_t handler[] = {
+        0x31, 0xDE, 0xAD, 0x73, // mov [0xDEAD], 0x73
+        0xB2, 0x40, 0x04        // jmp 0x4004
+    };
+    const uint8_t vector[] = {0x40, 0x00};
+
+    system.store(0x0000, sled);
+    system.store(0x0100, loop);
+    system.store(0x4000, handler);
+    system.store(interrupts::vector_of(0), vector);
+
+    // one CPU cycle is two half cycles
+    auto router = interrupts::Router{*interrupts::parse_config("vsync=0"), 2u};
+    auto port = interrupts::CpuPort<Vcpu>{&router};
+
+    auto recorder = trace::CpuRecorder{"cpu", trace_cycles};
+    const auto traced = TraceOnFailure{&recorder};
+
+    for (uint64_t i = 0; i < 2000; i++) {
+        if (i == 40) {
+            router.raise(interrupts::Source::Vsync, i);
+        }
+        system.half_cycle();
+        port.update(system.cpu, i);
+        recorder.capture(system.cpu);
+    }
+
+    CHECK_EQ(system.read(0xDEAD), 0x73);
+    CHECK_EQ(router.stats[0].latency.count, 1u);
+    CHECK_EQ(router.lines(), 0u);
+    CHECK_GE(system.pc(), 0x4004u);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Vmem_unit.h"
+
+// Drives Vmem_unit the same way the control unit would, shared by the memory and CPU tests
+
+enum ReadFlags {
+    READ_ZP = 1, // zero page
+    READ_HP = 2, // high part
+};
+
+enum WriteFlags {
+    WRITE_ZP = 1, // zero page
+    WRITE_HP = 2, // high part
+};
+
+inline void reset(Vmem_unit& mem) {
+    mem.zero_page = 1;
+    mem.mem_part = 0;
+    mem.mem_out = 1;
+    mem.mem_in = 1;
+    mem.reg_mbr_load = 0;
+    mem.reg_mar_load = 0;
+    mem.reg_mbr_word_dir = 1;
+    mem.data_in_en = 0;
+    //mem.reg_mbr_use_bus = 1;
+}
+
+inline void load_mar_mbr(Vmem_unit& mem, int addr, int data) {
+    mem.reg_mar_load = 1;
+    mem.reg_mbr_load = 1;
+    mem.mem_out = 1;
+    mem.mem_in = 1;
+    mem.mem_part = 0;
+    mem.zero_page = 1;
+    mem.reg_mbr_word_dir = 1;
+    mem.data_in = data;
+    mem.data_in_en = 1;
+    mem.address = addr;
+    //mem.reg_mbr_use_bus = 0;
+}
+
+inline void load_mbr_to_mem(Vmem_unit& mem, int flags = 0) {
+    mem.reg_mar_load = 0;
+    mem.reg_mbr_load = 0;
+    mem.mem_out = 1;
+    mem.mem_in = 0;
+    mem.mem_part = (flags & READ_HP) ? 1 : 0;
+    mem.zero_page = (flags & READ_ZP) ? 0 : 1;
+    mem.reg_mbr_word_dir = 1;
+    mem.data_in_en = 0;
+    //mem.reg_mbr_use_bus = 1;
+}
+
+inline void load_mem(Vmem_unit& mem, int flags = 0) {
+    mem.reg_mar_load = 0;
+    mem.reg_mbr_load = 0;
+    mem.mem_out = 0;
+    mem.mem_in = 1;
+    mem.mem_part = (flags & READ_HP) ? 1 : 0;
+    mem.zero_page = (flags & READ_ZP) ? 0 : 1;
+    mem.reg_mbr_word_dir = 0;
+    mem.data_in_en = 0;
+    //mem.reg_mbr_use_bus = 0;
+}
+
+inline void load_mar(Vmem_unit& mem, int addr) {
+    mem.reg_mar_load = 1;
+    mem.reg_mbr_load = 0;
+    mem.mem_out = 1;
+    mem.mem_in = 1;
+    mem.mem_part = 0;
+    mem.zero_page = 1;
+    mem.reg_mbr_word_dir = 1;
+    mem.address = addr;
+    mem.data_in_en = 0;
+    //mem.reg_mbr_use_bus = 0;
+}
@@ -1,82 +1,10 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest/doctest.h"
 #include "Vmem_unit.h"
+#include "mem_unit_helpers.hpp"
 #include "verilated.h"
 #include <iostream>
 
-enum ReadFlags {
-    READ_ZP = 1, // zero page
-    READ_HP = 2, // high part
-};
-
-enum WriteFlags {
-    WRITE_ZP = 1, // zero page
-    WRITE_HP = 2, // high part
-};
-
-void reset(Vmem_unit& mem) {
-    mem.zero_page = 1;
-    mem.mem_part = 0;
-    mem.mem_out = 1;
-    mem.mem_in = 1;
-    mem.reg_mbr_load = 0;
-    mem.reg_mar_load = 0;
-    mem.reg_mbr_word_dir = 1;
-    mem.data_in_en = 0;
-    //mem.reg_mbr_use_bus = 1;
-}
-
-void load_mar_mbr(Vmem_unit& mem, int addr, int data) {
-    mem.reg_mar_load = 1;
-    mem.reg_mbr_load = 1;
-    mem.mem_out = 1;
-    mem.mem_in = 1;
-    mem.mem_part = 0;
-    mem.zero_page = 1;
-    mem.reg_mbr_word_dir = 1;
-    mem.data_in = data;
-    mem.data_in_en = 1;
-    mem.address = addr;
-    //mem.reg_mbr_use_bus = 0;
-}
-
-void load_mbr_to_mem(Vmem_unit& mem, int flags = 0) {
-    mem.reg_mar_load = 0;
-    mem.reg_mbr_load = 0;
-    mem.mem_out = 1;
-    mem.mem_in = 0;
-    mem.mem_part = (flags & READ_HP) ? 1 : 0;
-    mem.zero_page = (flags & READ_ZP) ? 0 : 1;
-    mem.reg_mbr_word_dir = 1;
-    mem.data_in_en = 0;
-    //mem.reg_mbr_use_bus = 1;
-}
-
-void load_mem(Vmem_unit& mem, int flags = 0) {
-    mem.reg_mar_load = 0;
-    mem.reg_mbr_load = 0;
-    mem.mem_out = 0;
-    mem.mem_in = 1;
-    mem.mem_part = (flags & READ_HP) ? 1 : 0;
-    mem.zero_page = (flags & READ_ZP) ? 0 : 1;
-    mem.reg_mbr_word_dir = 0;
-    mem.data_in_en = 0;
-    //mem.reg_mbr_use_bus = 0;
-}
-
-void load_mar(Vmem_unit& mem, int addr) {
-    mem.reg_mar_load = 1;
-    mem.reg_mbr_load = 0;
-    mem.mem_out = 1;
-    mem.mem_in = 1;
-    mem.mem_part = 0;
-    mem.zero_page = 1;
-    mem.reg_mbr_word_dir = 1;
-    mem.address = addr;
-    mem.data_in_en = 0;
-    //mem.reg_mbr_use_bus = 0;
-}
-
 TEST_CASE("Read/write from/to first byte works") {
     Vmem_unit mem;
 
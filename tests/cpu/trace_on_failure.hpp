@@ -0,0 +1,72 @@
+#pragma once
+
+#include "doctest/doctest.h"
+#include "trace.hpp"
+#include <algorithm>
+#include <fmt/base.h>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+// Writes the trace windows of the running test to `<test name>.fst` when one of its assertions fails.
+// Include it once per test executable, next to DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN.
+//
+//   auto recorder = trace::CpuRecorder{"cpu", 256};
+//   const auto traced = TraceOnFailure{&recorder};
+//   ... recorder.capture(cpu) after every eval ...
+
+struct TraceOnFailure {
+    explicit TraceOnFailure(std::initializer_list<const trace::CpuRecorder *> attach) {
+        recorders().assign(attach.begin(), attach.end());
+    }
+    ~TraceOnFailure() { recorders().clear(); }
+
+    TraceOnFailure(const TraceOnFailure &) = delete;
+    auto operator=(const TraceOnFailure &) -> TraceOnFailure & = delete;
+
+    static auto recorders() -> std::vector<const trace::CpuRecorder *> & {
+        static auto attached = std::vector<const trace::CpuRecorder *>{};
+        return attached;
+    }
+};
+
+// Dumps on the first failed assertion, while the test's recorders are still alive - a doctest listener only
+// hears about the end of a test case after its locals are gone
+struct TraceOnFailureListener : doctest::IReporter {
+    explicit TraceOnFailureListener(const doctest::ContextOptions &) {}
+
+    void report_query(const doctest::QueryData &) override {}
+    void test_run_start() override {}
+    void test_run_end(const doctest::TestRunStats &) override {}
+    void test_case_reenter(const doctest::TestCaseData &) override {}
+    void test_case_end(const doctest::CurrentTestCaseStats &) override {}
+    void test_case_exception(const doctest::TestCaseException &) override {}
+    void subcase_start(const doctest::SubcaseSignature &) override {}
+    void subcase_end() override {}
+    void log_message(const doctest::MessageData &) override {}
+    void test_case_skipped(const doctest::TestCaseData &) override {}
+
+    void test_case_start(const doctest::TestCaseData &data) override {
+        path = std::string{data.m_name} + ".fst";
+        std::ranges::replace(path, ' ', '_');
+        dumped = false;
+    }
+
+    void log_assert(const doctest::AssertData &data) override {
+        const auto &recorders = TraceOnFailure::recorders();
+        if (!data.m_failed || dumped || recorders.empty()) {
+            return;
+        }
+
+        dumped = true;
+        if (trace::write_fst(path, recorders)) {
+            fmt::println(stderr, "trace window written to {}", path);
+        }
+    }
+
+  private:
+    std::string path{};
+    bool dumped = false;
+};
+
+REGISTER_LISTENER("trace_on_failure", 1, TraceOnFailureListener);
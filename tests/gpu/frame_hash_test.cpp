@@ -0,0 +1,189 @@
+#define DOCTEST_CONFIG_IMPLEMENT
+#include "doctest/doctest.h"
+#include "Vgpu.h"
+#include "Vpattern_tester.h"
+#include "frame_hash.hpp"
+#include "gpu_command_port.hpp"
+#include "vga_simulator.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+
+// Every frame is hashed and compared against golden_frame_hashes.txt, one `name hash` per line. A frame without a
+// golden hash fails like one that differs, GOLDEN_UPDATE=1 records the missing hashes and rewrites the ones that
+// differ instead. Reports the frames/s of the capture path at the end.
+//
+// While the file holds no hash at all the test is skipped, ctest reports it as such (exit code 77), until the hashes
+// are recorded on a build of the RTL with `just golden-hashes`.
+
+namespace {
+    struct GoldenHashes {
+        constexpr static auto header =
+            "# Frame hashes checked by tests/gpu/frame_hash_test.cpp, rewritten by the test when GOLDEN_UPDATE=1 is\n"
+            "# set\n";
+
+        GoldenHashes() : update(std::getenv("GOLDEN_UPDATE") != nullptr) {
+            auto file = std::ifstream{GOLDEN_FRAME_HASHES};
+            for (auto line = std::string{}; std::getline(file, line);) {
+                const auto space = line.find(' ');
+                if (line.empty() || line.front() == '#' || space == std::string::npos) {
+                    continue;
+                }
+                hashes[line.substr(0, space)] = std::stoull(line.substr(space + 1), nullptr, 16);
+            }
+        }
+
+        ~GoldenHashes() {
+            if (changed) {
+                auto *file = std::fopen(GOLDEN_FRAME_HASHES, "w");
+                if (file != nullptr) {
+                    std::fputs(header, file);
+                    for (const auto &[name, hash] : hashes) {
+                        fmt::println(file, "{} {:016x}", name, hash);
+                    }
+                    std::fclose(file);
+                    fmt::println("golden frame hashes written to {}", GOLDEN_FRAME_HASHES);
+                }
+            }
+            if (seconds > 0.0) {
+                fmt::println("{} frames in {:.3f} s, {:.2f} frames/s", frames, seconds,
+                             static_cast<double>(frames) / seconds);
+            }
+        }
+
+        void check(const std::string &name, uint64_t hash) {
+            const auto golden = hashes.find(name);
+            if (update && (golden == hashes.end() || golden->second != hash)) {
+                hashes[name] = hash;
+                changed = true;
+                return;
+            }
+
+            CAPTURE(name);
+            if (golden == hashes.end()) {
+                FAIL_CHECK("no golden hash, record it with `just golden-hashes`");
+                return;
+            }
+            const auto expected = fmt::format("{:016x}", golden->second);
+            const auto actual = fmt::format("{:016x}", hash);
+            CHECK_EQ(actual, expected);
+        }
+
+        std::map<std::string, uint64_t> hashes{};
+        bool update;
+        bool changed = false;
+        uint64_t frames = 0u;
+        double seconds = 0.0;
+    };
+
+    auto golden() -> GoldenHashes & {
+        static auto hashes = GoldenHashes{};
+        return hashes;
+    }
+
+    // Hashes the next `count` frames as `<name>/<index>`
+    template <typename Driver> void check_frames(VGASimulator<Driver> &simulator, const std::string &name, int count) {
+        const auto start = std::chrono::steady_clock::now();
+        for (auto i = 0; i < count; i++) {
+            auto hash = FrameHash{};
+            const auto frame = simulator.process_vga_frame(
+                [&hash](const uint32_t, const uint32_t, const Color color) { hash.add(color); });
+            REQUIRE(frame.has_value());
+            golden().check(fmt::format("{}/{}", name, i), hash.value);
+        }
+        golden().frames += static_cast<uint64_t>(count);
+        golden().seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // `pattern` as selected in Pattern_Tester.v
+    void check_pattern(const std::string &name, uint8_t pattern, int frames, uint8_t red = 0, uint8_t green = 0,
+                       uint8_t blue = 0) {
+        Vpattern_tester tester{};
+        tester.pattern = pattern;
+        tester.fill_red = red;
+        tester.fill_green = green;
+        tester.fill_blue = blue;
+
+        auto clock = Clock{&tester, 1, 0, true};
+        auto scheduler = ClockScheduler{};
+        scheduler.add_clock(&clock);
+
+        auto simulator = VGASimulator{&tester, &scheduler};
+        REQUIRE(simulator.sync().has_value());
+        check_frames(simulator, name, frames);
+        CHECK_EQ(simulator.sync_checker.result().total(), 0u);
+    }
+
+    // Runs `script` through the command port until the GPU is idle, then hashes the screen
+    void check_screen(const std::string &name, const std::function<void(GpuCommandPort<Vgpu> &)> &script,
+                      int frames = 2) {
+        Vgpu gpu{};
+        gpu.rst = 0;
+        auto port = GpuCommandPort{&gpu};
+        auto clock = Clock{&port, 1, 0, true};
+        auto scheduler = ClockScheduler{};
+        scheduler.add_clock(&clock);
+
+        auto simulator = VGASimulator{&gpu, &scheduler};
+        REQUIRE(simulator.sync().has_value());
+
+        script(port);
+        for (auto i = 0; !port.empty() || gpu.busy; i++) {
+            REQUIRE_LT(i, 4);
+            REQUIRE(simulator.process_vga_frame([](const uint32_t, const uint32_t, const Color) {}).has_value());
+        }
+        check_frames(simulator, name, frames);
+    }
+}
+
+auto main(int argc, char **argv) -> int {
+    if (!golden().update && golden().hashes.empty()) {
+        fmt::println("no golden frame hashes in {}, record them with `just golden-hashes`", GOLDEN_FRAME_HASHES);
+        return 77;
+    }
+    return doctest::Context{argc, argv}.run();
+}
+
+TEST_CASE("Monitor_Tester patterns") {
+    check_pattern("gradient", 0, 2);
+    check_pattern("grid", 1, 2);
+    check_pattern("tv", 2, 2);
+    check_pattern("fill_color", 4, 2, 0x3, 0x9, 0xc);
+}
+
+TEST_CASE("Monitor_Tester bouncing square") {
+    // moves every 100001 cycles, a few pixels per frame
+    check_pattern("bouncing_square", 3, 200);
+}
+
+TEST_CASE("GPU text screens") {
+    check_screen("gpu/empty", [](auto &) {});
+    check_screen("gpu/hello", [](auto &port) { port.write("Hello, world!"); });
+    check_screen("gpu/all_characters", [](auto &port) {
+        for (auto i = 0u; i < 80u * 60u; i++) {
+            port.store_byte(static_cast<uint8_t>(i));
+        }
+    });
+    check_screen("gpu/cleared", [](auto &port) {
+        port.write("gone after the clear");
+        port.clear('#');
+    });
+    check_screen("gpu/scrolled", [](auto &port) {
+        for (auto row = 0; row < 60; row++) {
+            port.write(fmt::format("{:<80}", fmt::format("line {}", row)));
+        }
+        port.scroll_to(5);
+    });
+    check_screen("gpu/flipped", [](auto &port) {
+        port.write("front page");
+        port.double_buffer(true);
+        port.write("back page");
+        port.flip();
+    });
+}
@@ -1,9 +1,165 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest/doctest.h"
 #include "Vgpu.h"
+#include "gpu_command_port.hpp"
+#include "screen_checks.hpp"
+#include "vga_simulator.hpp"
 #include "verilated.h"
 #include <iostream>
 
 TEST_CASE("GPU test") {
     CHECK(0 == 0);
 }
+
+namespace {
+    // GPU cycles until everything queued on the port was written
+    auto cycles_until_idle(GpuCommandPort<Vgpu> &port, Vgpu &gpu, uint64_t limit = 4u * 80u * 60u) -> uint64_t {
+        auto clock = Clock{&port, 1, 0, true};
+        auto scheduler = ClockScheduler{};
+        scheduler.add_clock(&clock);
+
+        while (!port.empty() || gpu.busy) {
+            scheduler.advance();
+            REQUIRE_LT(scheduler.time, limit);
+        }
+        return scheduler.time;
+    }
+}
+
+TEST_CASE("Command port writes a full screen in three cycles per character") {
+    Vgpu gpu{};
+    gpu.rst = 0;
+    auto port = GpuCommandPort{&gpu};
+
+    for (auto i = 0u; i < 80u * 60u; i++) {
+        port.store_byte(static_cast<uint8_t>(i));
+    }
+
+    const auto cycles = cycles_until_idle(port, gpu);
+    CHECK_EQ(port.issued, 80u * 60u);
+    CHECK_LE(cycles, 3u * 80u * 60u + 4u);
+}
+
+TEST_CASE("Clearing the screen takes one cycle per cell") {
+    Vgpu gpu{};
+    gpu.rst = 0;
+    auto port = GpuCommandPort{&gpu};
+
+    port.clear();
+    const auto cycles = cycles_until_idle(port, gpu);
+    MESSAGE("SIG_CLEAR took " << cycles << " cycles, 4800 stores take about " << 3u * 80u * 60u);
+    CHECK_GE(cycles, 80u * 60u);
+    CHECK_LE(cycles, 80u * 60u + 4u);
+
+    // a store right after the clear is not lost
+    port.store_byte('x');
+    cycles_until_idle(port, gpu);
+    CHECK_EQ(port.issued, 2u);
+}
+
+TEST_CASE("Scrolling a line costs one command and the new bottom row") {
+    Vgpu gpu{};
+    gpu.rst = 0;
+    auto port = GpuCommandPort{&gpu};
+
+    port.scroll_to(1);
+    port.move_cursor_rows(-1);
+    for (auto i = 0u; i < 80u; i++) {
+        port.store_byte('-');
+    }
+
+    const auto cycles = cycles_until_idle(port, gpu);
+    CHECK_EQ(port.issued, 82u);
+    CHECK_LE(cycles, 2u + 3u * 80u + 4u);
+}
+
+TEST_CASE("A page flip waits for vsync and holds back later writes") {
+    Vgpu gpu{};
+    gpu.rst = 0;
+    auto port = GpuCommandPort{&gpu};
+    constexpr auto frame = 800u * 525u;
+
+    port.double_buffer(true);
+    port.write("back page");
+    cycles_until_idle(port, gpu);
+    CHECK(gpu.double_buffered);
+    CHECK_EQ(gpu.display_page, 0);
+
+    port.flip();
+    port.store_byte('x');
+    const auto cycles = cycles_until_idle(port, gpu, 2u * frame);
+    CHECK_EQ(gpu.display_page, 1);
+    CHECK_LE(cycles, frame + 8u);
+    CHECK_EQ(port.issued, 1u + 9u + 1u + 1u);
+}
+
+TEST_CASE("Analytic sync ends where scanning for sync pulses does") {
+    for (const auto offset : {0u, 1u, 5000u, 123457u, 300001u}) {
+        CAPTURE(offset);
+        Vgpu scanned{};
+        Vgpu computed{};
+        scanned.rst = 0;
+        computed.rst = 0;
+
+        auto scanned_clock = Clock{&scanned, 1, 0, true};
+        auto computed_clock = Clock{&computed, 1, 0, true};
+        auto scanned_scheduler = ClockScheduler{};
+        auto computed_scheduler = ClockScheduler{};
+        scanned_scheduler.add_clock(&scanned_clock);
+        computed_scheduler.add_clock(&computed_clock);
+        for (auto i = 0u; i < offset; i++) {
+            scanned_scheduler.advance();
+            computed_scheduler.advance();
+        }
+
+        auto scanning_simulator = VGASimulator{&scanned, &scanned_scheduler};
+        auto computing_simulator = VGASimulator{&computed, &computed_scheduler};
+        REQUIRE(scanning_simulator.sync_by_edges().has_value());
+        REQUIRE(computing_simulator.sync().has_value());
+        CHECK(vga_position(computed) == vga_position(scanned));
+        CHECK_EQ(vga_position(computed).h_region, VGAPosition::Display);
+        CHECK_LE(computed_scheduler.time - offset, scanned_scheduler.time - offset);
+    }
+}
+
+TEST_CASE("Text screen reads what was written, scrolled and flipped") {
+    Vgpu gpu{};
+    gpu.rst = 0;
+    auto port = GpuCommandPort{&gpu};
+
+    // the cursor moves before every store, "world" starts at the cell after 79
+    port.clear();
+    port.write("Hello");
+    port.move_cursor_rows(1);
+    port.move_cursor_columns(-5);
+    port.write("world");
+    cycles_until_idle(port, gpu, 2u * 80u * 60u);
+
+    check_screen_text(gpu, "Hello\nworld");
+    const auto screen = read_text_screen(gpu);
+    CHECK_EQ(screen.at(1, 1).character, 'o');
+    const auto world = screen.find("world");
+    REQUIRE(world.has_value());
+    CHECK_EQ(world->second, 1u);
+
+    // scrolling by one row wraps the top row around to the bottom
+    port.scroll_to(1);
+    cycles_until_idle(port, gpu);
+    check_screen_rows(gpu, {"world"});
+    check_screen_rows(gpu, {"Hello"}, 59u);
+
+    // with double buffering the back page is written, the shown one stays until the flip
+    port.scroll_to(0);
+    port.double_buffer(true);
+    port.clear();
+    port.write("back");
+    cycles_until_idle(port, gpu, 2u * 80u * 60u);
+    check_screen_rows(gpu, {"Hello"});
+    check_screen_rows(read_text_screen(gpu, ScreenPage::Back), {"back"});
+
+    // the pages swap, the old front page is written next
+    port.flip();
+    cycles_until_idle(port, gpu, 2u * 800u * 525u);
+    check_screen_text(gpu, "back");
+    CHECK_EQ(read_text_screen(gpu, ScreenPage::Back).text(), "Hello\nworld");
+}
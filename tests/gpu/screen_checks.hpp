@@ -0,0 +1,36 @@
+#pragma once
+
+#include "doctest/doctest.h"
+#include "text_screen.hpp"
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+
+// Screen assertions on the GPU's text grid, without simulating a frame:
+//
+//   check_screen_rows(gpu, {"Hello", "world"});    // rows 0 and 1, trailing spaces don't matter
+//   check_screen_rows(gpu, {"prompt>"}, 59);       // starting at the last row
+//   check_screen_text(gpu, "Hello\nworld");        // the whole screen
+//
+// A failure shows the row and both strings.
+
+inline void check_screen_rows(const TextScreen &screen, std::initializer_list<std::string_view> expected,
+                              uint32_t first_row = 0u) {
+    auto row = first_row;
+    for (const auto line : expected) {
+        REQUIRE(row < TextScreen::rows);
+        CAPTURE(row);
+        CHECK_EQ(screen.row_text(row), std::string{line});
+        row++;
+    }
+}
+
+inline void check_screen_rows(const Vgpu &gpu, std::initializer_list<std::string_view> expected,
+                              uint32_t first_row = 0u) {
+    check_screen_rows(read_text_screen(gpu), expected, first_row);
+}
+
+inline void check_screen_text(const Vgpu &gpu, std::string_view expected) {
+    CHECK_EQ(read_text_screen(gpu).text(), std::string{expected});
+}
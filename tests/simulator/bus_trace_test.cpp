@@ -0,0 +1,139 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+#include "bus_trace.hpp"
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+    using bus_trace::Kind;
+    using bus_trace::Transaction;
+
+    // A copy loop: read from 0x1000 + i, write to 0x2000 + i, like the memcpy workload
+    auto copy_trace(uint16_t bytes) -> std::vector<Transaction> {
+        auto trace = std::vector<Transaction>{};
+        auto cycle = uint64_t{0};
+        for (auto i = uint16_t{0}; i < bytes; i++) {
+            const auto src = static_cast<uint16_t>(0x1000u + i);
+            const auto dst = static_cast<uint16_t>(0x2000u + i);
+            const auto value = static_cast<uint8_t>(i * 7u);
+            trace.push_back({cycle += 3u, src, 0u, Kind::MarLoad, true, false});
+            trace.push_back({cycle += 2u, src, value, Kind::Read, true, false});
+            trace.push_back({cycle += 3u, dst, 0u, Kind::MarLoad, true, false});
+            trace.push_back({cycle += 1u, dst, value, Kind::MbrLoad, true, false});
+            trace.push_back({cycle += 2u, dst, value, Kind::Write, true, false});
+        }
+        return trace;
+    }
+
+    struct ArrayBackend {
+        std::array<uint8_t, 0x10000> memory{};
+        uint16_t mar = 0u;
+        uint8_t mbr = 0u;
+
+        void load_mar(uint16_t address) { mar = address; }
+        void load_mbr(uint8_t data) { mbr = data; }
+        auto read(bool, bool) -> uint8_t { return memory[mar]; }
+        void write(bool, bool) { memory[mar] = mbr; }
+    };
+}
+
+TEST_CASE("Encoding is delta compressed") {
+    const auto trace = copy_trace(64);
+    auto bytes = std::vector<uint8_t>{};
+    auto previous = Transaction{};
+    for (const auto &transaction : trace) {
+        bus_trace::encode(transaction, previous, bytes);
+        previous = transaction;
+    }
+
+    // header, cycle delta and a one or two byte address delta, plus data where it applies
+    CHECK_LT(bytes.size(), trace.size() * 5u);
+}
+
+TEST_CASE("Transactions written by the background thread read back unchanged") {
+    const auto path = std::string{"bus_trace_test.bustrace"};
+    const auto trace = copy_trace(1000);
+
+    {
+        auto writer = bus_trace::Writer{path};
+        REQUIRE(writer.is_open());
+        for (const auto &transaction : trace) {
+            writer.record(transaction);
+        }
+    }
+
+    const auto read = bus_trace::read(path);
+    std::remove(path.c_str());
+    REQUIRE(read.has_value());
+    REQUIRE_EQ(read->size(), trace.size());
+    CHECK(*read == trace);
+}
+
+TEST_CASE("Missing or foreign files are not read") {
+    CHECK_FALSE(bus_trace::read("does_not_exist.bustrace").has_value());
+
+    const auto path = std::string{"bus_trace_test.txt"};
+    auto *file = std::fopen(path.c_str(), "wb");
+    std::fputs("not a trace", file);
+    std::fclose(file);
+    CHECK_FALSE(bus_trace::read(path).has_value());
+    std::remove(path.c_str());
+}
+
+TEST_CASE("A trace with its preloaded memory replays from empty memory") {
+    const auto path = std::string{"bus_trace_preload_test.bustrace"};
+    auto source = std::array<uint8_t, 16>{};
+    for (auto i = 0u; i < source.size(); i++) {
+        source[i] = static_cast<uint8_t>(i * 7u);
+    }
+
+    {
+        auto writer = bus_trace::Writer{path};
+        REQUIRE(writer.is_open());
+        for (const auto &transaction : bus_trace::preload(0x1000u, source)) {
+            writer.record(transaction);
+        }
+        for (const auto &transaction : copy_trace(16)) {
+            writer.record(transaction);
+        }
+    }
+
+    const auto trace = bus_trace::read(path);
+    std::remove(path.c_str());
+    REQUIRE(trace.has_value());
+
+    auto backend = ArrayBackend{};
+    const auto result = bus_trace::replay(*trace, backend);
+    CHECK_EQ(result.transactions, 16u * 3u + copy_trace(16).size());
+    CHECK_EQ(result.mismatches, 0u);
+    CHECK_EQ(backend.memory[0x2005], 35u);
+
+    // without the preload every source read mismatches
+    auto empty = ArrayBackend{};
+    CHECK_EQ(bus_trace::replay(copy_trace(16), empty).mismatches, 15u);
+}
+
+TEST_CASE("Replay reports reads that do not match the trace") {
+    auto trace = copy_trace(16);
+
+    // the source bytes were loaded before the trace started
+    auto backend = ArrayBackend{};
+    for (auto i = 0u; i < 16u; i++) {
+        backend.memory[0x1000u + i] = static_cast<uint8_t>(i * 7u);
+    }
+    auto copy = backend;
+
+    const auto matching = bus_trace::replay(trace, backend);
+    CHECK_EQ(matching.transactions, trace.size());
+    CHECK_EQ(matching.mismatches, 0u);
+    CHECK_EQ(backend.memory[0x2005], 35u);
+
+    copy.memory[0x1003] = 0xFF;
+    const auto mismatching = bus_trace::replay(trace, copy);
+    CHECK_EQ(mismatching.mismatches, 1u);
+    REQUIRE(mismatching.first_mismatch.has_value());
+    CHECK_EQ(mismatching.first_mismatch->address, 0x1003u);
+}
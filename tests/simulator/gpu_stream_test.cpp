@@ -0,0 +1,167 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+#include "clockable_module.hpp"
+#include "gpu_command_port.hpp"
+#include "gpu_stream.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+    using gpu_stream::Code;
+    using gpu_stream::Command;
+
+    // Logs every interrupt pulse with the number of rising clock edges before it
+    struct FakeGpu {
+        uint8_t clk = 0;
+        uint8_t interrupt_enable = 0;
+        uint8_t interrupt_code_in = 0;
+        uint8_t interrupt_data_in = 0;
+
+        uint64_t edges = 0u;
+        std::vector<Command> received{};
+
+        void eval() {
+            if (clk && !last_clk) {
+                edges++;
+            }
+            last_clk = clk;
+
+            if (interrupt_enable && !last_enable) {
+                received.push_back({edges, static_cast<Code>(interrupt_code_in), interrupt_data_in});
+            }
+            last_enable = interrupt_enable;
+        }
+
+      private:
+        uint8_t last_clk = 0;
+        uint8_t last_enable = 0;
+    };
+
+    // Busy for three rising edges after every store, like the write pipeline of gpu.sv
+    struct FakeBusyGpu : FakeGpu {
+        uint8_t busy = 0;
+
+        void eval() {
+            const auto rising = clk && !was_clk;
+            was_clk = clk;
+            const auto before = received.size();
+            FakeGpu::eval();
+
+            if (rising && write_edges > 0u) {
+                write_edges--;
+            }
+            if (received.size() != before && received.back().code == Code::StoreByte) {
+                CHECK_EQ(write_edges, 0u);
+                write_edges = 3u;
+            }
+            busy = write_edges > 0u;
+        }
+
+      private:
+        uint8_t was_clk = 0;
+        uint32_t write_edges = 0u;
+    };
+}
+
+TEST_CASE("Recorded commands read back unchanged") {
+    const auto path = std::string{"gpu_stream_test.gpucmd"};
+    const auto commands = std::vector<Command>{
+        {1234u, Code::MoveCursor, 0x81},
+        {1234u, Code::StoreByte, 'A'},
+        {uint64_t{1} << 40, Code::Clear, 0x00},
+    };
+
+    {
+        auto recorder = gpu_stream::Recorder{path};
+        REQUIRE(recorder.is_open());
+        for (const auto &command : commands) {
+            recorder.record(command);
+        }
+    }
+
+    const auto read = gpu_stream::read(path);
+    std::remove(path.c_str());
+    REQUIRE(read.has_value());
+    CHECK(*read == commands);
+}
+
+TEST_CASE("Broken command streams are rejected") {
+    const auto path = std::string{"gpu_stream_broken_test.gpucmd"};
+    {
+        auto recorder = gpu_stream::Recorder{path};
+        recorder.record({1u, Code::StoreByte, 'A'});
+        recorder.record({2u, static_cast<Code>(0b100u), 0x00});
+    }
+    CHECK_FALSE(gpu_stream::read(path).has_value());
+
+    {
+        auto recorder = gpu_stream::Recorder{path};
+        recorder.record({1u, Code::StoreByte, 'A'});
+    }
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1u);
+    CHECK_FALSE(gpu_stream::read(path).has_value());
+
+    CHECK_FALSE(gpu_stream::read("does_not_exist.gpucmd").has_value());
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Replay sends every command after the GPU's clock edge at its time") {
+    const auto commands = std::vector<Command>{
+        {3u, Code::StoreByte, 'a'},
+        {3u, Code::StoreByte, 'b'},
+        {10u, Code::MoveCursor, 0x01},
+        {11u, Code::StoreByte, 'c'},
+    };
+
+    auto gpu = FakeGpu{};
+    auto gpu_clock = Clock{&gpu, 1, 0, true};
+    auto replay_clock = gpu_stream::ReplayClock{&gpu, std::span{commands}};
+    auto scheduler = ClockScheduler{};
+    scheduler.add_clock(&gpu_clock);
+    scheduler.add_clock(&replay_clock);
+
+    while (scheduler.time < 20u) {
+        scheduler.advance();
+    }
+
+    CHECK(replay_clock.done());
+    REQUIRE_EQ(gpu.received.size(), commands.size());
+    for (auto i = 0u; i < commands.size(); i++) {
+        CHECK_EQ(gpu.received[i].code, commands[i].code);
+        CHECK_EQ(gpu.received[i].data, commands[i].data);
+        // a clock with a period of 1 has its T-th rising edge at time T
+        CHECK_EQ(gpu.received[i].time, commands[i].time);
+    }
+}
+
+TEST_CASE("Command port waits for the GPU between writes") {
+    auto gpu = FakeBusyGpu{};
+    auto port = GpuCommandPort{&gpu};
+    auto clock = Clock{&port, 1, 0, true};
+    auto scheduler = ClockScheduler{};
+    scheduler.add_clock(&clock);
+
+    port.write("abc");
+    port.move_cursor_columns(-1);
+    port.move_cursor_rows(1);
+    CHECK_EQ(port.pending(), 5u);
+
+    while (!port.empty() || gpu.busy) {
+        scheduler.advance();
+    }
+
+    REQUIRE_EQ(gpu.received.size(), 5u);
+    CHECK_EQ(gpu.received[0].data, 'a');
+    CHECK_EQ(gpu.received[2].data, 'c');
+    CHECK_EQ(gpu.received[3].data, 0xFF);
+    CHECK_EQ(gpu.received[4].data, 0x01);
+    // a store every three edges, a cursor move right after the previous one
+    CHECK_EQ(gpu.received[1].time - gpu.received[0].time, 3u);
+    CHECK_EQ(gpu.received[2].time - gpu.received[1].time, 3u);
+    CHECK_EQ(gpu.received[4].time - gpu.received[3].time, 1u);
+    CHECK_EQ(port.issued, 5u);
+    CHECK_EQ(port.stalled, 2u * 2u + 2u);
+}
@@ -0,0 +1,63 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+#include "input_stream.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+    using input_stream::Event;
+    using input_stream::Kind;
+
+    auto session() -> std::vector<Event> {
+        return {
+            {.time = 1'234u, .kind = Kind::Frame, .value = 0u},
+            {.time = 421'234u, .kind = Kind::Key, .value = 73u},
+            {.time = 421'234u, .kind = Kind::Char, .value = 0x1F600u},
+            {.time = 421'234u, .kind = Kind::KeyPress, .value = 65u},
+            {.time = 621'234u, .kind = Kind::KeyRelease, .value = 65u},
+            {.time = 0xFEDC'BA98'7654'3210u, .kind = Kind::Frame, .value = 0u},
+        };
+    }
+}
+
+TEST_CASE("Recorded input reads back unchanged") {
+    const auto path = std::string{"input_stream_test.bin"};
+    const auto events = session();
+    {
+        auto recorder = input_stream::Recorder{path};
+        REQUIRE(recorder.is_open());
+        for (const auto &event : events) {
+            recorder.record(event);
+        }
+    }
+
+    const auto read = input_stream::read(path);
+    REQUIRE(read.has_value());
+    CHECK(*read == events);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Broken input recordings are rejected") {
+    const auto path = std::string{"input_stream_broken_test.bin"};
+    {
+        auto recorder = input_stream::Recorder{path};
+        recorder.record({.time = 1u, .kind = Kind::Key, .value = 265u});
+        recorder.record({.time = 2u, .kind = static_cast<Kind>(7u), .value = 0u});
+    }
+    CHECK_FALSE(input_stream::read(path).has_value());
+
+    {
+        auto recorder = input_stream::Recorder{path};
+        for (const auto &event : session()) {
+            recorder.record(event);
+        }
+    }
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1u);
+    CHECK_FALSE(input_stream::read(path).has_value());
+
+    CHECK_FALSE(input_stream::read("does_not_exist.bin").has_value());
+    std::remove(path.c_str());
+}
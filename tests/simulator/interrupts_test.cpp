@@ -0,0 +1,242 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+#include "clockable_module.hpp"
+#include "interrupts.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+    using interrupts::Source;
+
+    constexpr auto ir_load = uint64_t{1} << 39u;
+    constexpr auto int_address_out = uint64_t{1} << 47u;
+
+    // The parts of Vcpu that CpuPort uses
+    struct FakeRoot {
+        uint64_t cpu_adapter__DOT__cpu__DOT__signals = 0u;
+    };
+
+    struct FakeCpu {
+        uint8_t int_in = 0u;
+        uint16_t addr_bus = 0u;
+        FakeRoot root{};
+        FakeRoot *rootp = &root;
+
+        void eval(interrupts::CpuPort<FakeCpu> &port, uint64_t signals, uint16_t address, uint64_t time) {
+            root.cpu_adapter__DOT__cpu__DOT__signals = signals;
+            addr_bus = address;
+            port.update(*this, time);
+        }
+
+        // one eval with REG_IR_LOAD at `pc` and one without
+        void fetch(interrupts::CpuPort<FakeCpu> &port, uint16_t pc, uint64_t time) {
+            eval(port, ir_load, pc, time);
+            eval(port, 0u, pc, time + 2u);
+        }
+
+        // The ISR microcode after the fetch it replaced: LOAD_ISR_ADDRESS_TO_PC_AND_MAR puts the vector on the
+        // address bus, the handler address is read from it and the next vector byte
+        void enter_isr(interrupts::CpuPort<FakeCpu> &port, uint16_t vector, uint64_t time) {
+            eval(port, int_address_out, vector, time);
+            eval(port, 0u, vector, time + 2u);
+            eval(port, 0u, static_cast<uint16_t>(vector + 1u), time + 4u);
+        }
+    };
+
+    auto routes() -> interrupts::Config {
+        auto config = interrupts::Config{};
+        config.lines[static_cast<std::size_t>(Source::Vsync)] = 0u;
+        config.lines[static_cast<std::size_t>(Source::Timer)] = 3u;
+        return config;
+    }
+}
+
+TEST_CASE("Vectors of the interrupt lines") {
+    CHECK_EQ(interrupts::vector_of(0), 0xFFF2u);
+    CHECK_EQ(interrupts::vector_of(4), 0xFFFAu);
+    CHECK_EQ(interrupts::line_of_vector(0xFFF3), 0u);
+    CHECK_EQ(interrupts::line_of_vector(0xFFFB), 4u);
+    CHECK_FALSE(interrupts::line_of_vector(0xFFF1).has_value());
+    CHECK_FALSE(interrupts::line_of_vector(0xFFFC).has_value());
+}
+
+TEST_CASE("SIM_INTERRUPTS configs") {
+    const auto config = interrupts::parse_config("vsync=0 ps2=1  timer=2:100000");
+    REQUIRE(config.has_value());
+    CHECK_EQ(config->lines[0], 0u);
+    CHECK_EQ(config->lines[1], 1u);
+    CHECK_EQ(config->lines[2], 2u);
+    CHECK_EQ(config->timer_cycles, 100000u);
+
+    CHECK_FALSE(interrupts::parse_config("vsync=5").has_value());
+    CHECK_FALSE(interrupts::parse_config("timer=2").has_value());
+    CHECK_FALSE(interrupts::parse_config("timer=2:0").has_value());
+    CHECK_FALSE(interrupts::parse_config("mouse=1").has_value());
+    CHECK_FALSE(interrupts::parse_config("vsync").has_value());
+}
+
+TEST_CASE("Latency histogram buckets") {
+    using interrupts::LatencyHistogram;
+    CHECK_EQ(LatencyHistogram::bucket_of(0), 0u);
+    CHECK_EQ(LatencyHistogram::bucket_of(1), 1u);
+    CHECK_EQ(LatencyHistogram::bucket_of(7), 3u);
+    CHECK_EQ(LatencyHistogram::bucket_of(8), 4u);
+    CHECK_EQ(LatencyHistogram::bucket_of(uint64_t{1} << 40u), LatencyHistogram::bucket_count - 1u);
+    CHECK_EQ(LatencyHistogram::bucket_start(4), 8u);
+}
+
+TEST_CASE("A line is held until the CPU enters its ISR") {
+    auto router = interrupts::Router{routes(), 4u};
+    auto port = interrupts::CpuPort<FakeCpu>{&router};
+    auto cpu = FakeCpu{};
+
+    router.raise(Source::Vsync, 100u);
+    // not routed
+    router.raise(Source::Ps2Byte, 100u);
+    port.update(cpu, 104u);
+    CHECK_EQ(cpu.int_in, 0b1u);
+
+    // the CPU only latched one edge
+    router.raise(Source::Vsync, 200u);
+    // the fetch at the interrupted PC, the control unit turns it into the ISR
+    cpu.fetch(port, 0x1234u, 300u);
+    CHECK_EQ(cpu.int_in, 0b1u);
+    // the vector of another line
+    cpu.enter_isr(port, interrupts::vector_of(3), 320u);
+    cpu.fetch(port, 0xC000u, 340u);
+    CHECK_EQ(cpu.int_in, 0b1u);
+    // fetches from the vector addresses are not ISR entries, the microcode never does them
+    cpu.fetch(port, 0xFFF2u, 360u);
+    CHECK_EQ(cpu.int_in, 0b1u);
+
+    cpu.fetch(port, 0x1235u, 400u);
+    cpu.enter_isr(port, interrupts::vector_of(0), 440u);
+    CHECK_EQ(cpu.int_in, 0b1u);
+    // the handler's first instruction, at the address stored in the vector
+    cpu.fetch(port, 0xA0B0u, 500u);
+    CHECK_EQ(cpu.int_in, 0u);
+
+    const auto &stats = router.stats[0];
+    CHECK_EQ(stats.raised, 2u);
+    CHECK_EQ(stats.coalesced, 1u);
+    CHECK_EQ(stats.latency.count, 1u);
+    CHECK_EQ(stats.latency.min, 100u);
+    CHECK_EQ(stats.latency.buckets[interrupts::LatencyHistogram::bucket_of(100u)], 1u);
+
+    // the ISR running on doesn't count again
+    cpu.fetch(port, 0xA0B2u, 520u);
+    CHECK_EQ(router.stats[0].latency.count, 1u);
+
+    // the line can be raised again
+    router.raise(Source::Vsync, 600u);
+    CHECK_EQ(router.lines(), 0b1u);
+
+    const auto report = router.report();
+    CHECK_NE(report.find("line 0 (vsync) at fff2: 3 raised, 1 coalesced, 1 serviced"), std::string::npos);
+}
+
+TEST_CASE("The timer raises its line every period") {
+    auto router = interrupts::Router{routes(), 4u};
+    auto scheduler = ClockScheduler{};
+    auto timer = interrupts::Timer{&router, &scheduler, 1000u};
+    scheduler.add_clock(&timer);
+
+    auto fetches = 0u;
+    for (auto i = 0u; i < 5u; i++) {
+        scheduler.advance();
+        CHECK_EQ(scheduler.time, (i + 1u) * 1000u);
+        CHECK_EQ(router.lines(), 0b1000u);
+        router.vector_read(interrupts::vector_of(3));
+        router.fetched(scheduler.time + 40u);
+        fetches++;
+    }
+    CHECK_EQ(router.stats[3].raised, 5u);
+    CHECK_EQ(router.stats[3].latency.count, fetches);
+    CHECK_EQ(router.stats[3].latency.max, 10u);
+
+    timer.set_period(0u);
+    CHECK_EQ(timer.get_time_till_next_tick(), std::numeric_limits<uint32_t>::max());
+}
+
+namespace {
+    // Microcode that enters an ISR at 0xF3 for every latched line: it reads the vector in step 2 and resets every
+    // latch in step 3, the last one. Every other opcode is a single blank step.
+    struct Microcode {
+        constexpr static auto isr = 0xF3u;
+
+        Microcode() : g(size), f(size), rom_int(size), branch(size) {
+            for (auto bus = 0u; bus < 32u; bus++) {
+                for (auto opcode = 0u; opcode < 256u; opcode++) {
+                    rom_int[bus << 8u | opcode] = static_cast<uint8_t>(bus == 0u ? opcode : isr);
+                }
+            }
+            for (auto inst = 0u; inst < 256u; inst++) {
+                for (auto flags = 0u; flags < 32u; flags++) {
+                    branch[inst << 5u | flags] = static_cast<uint8_t>(inst);
+                }
+                f[inst << 4u] = mcc_rst;
+            }
+            f[isr << 4u] = 0u;
+            g[isr << 4u | 2u] = int_address_out;
+            g[isr << 4u | 3u] = 0xF8u;
+            f[isr << 4u | 3u] = mcc_rst;
+        }
+
+        auto write() const -> std::string {
+            const auto directory = std::filesystem::temp_directory_path() / "interrupts_test_roms";
+            std::filesystem::create_directories(directory);
+            for (const auto &[name, rom] : {std::pair{"G.bin", &g}, std::pair{"F.bin", &f},
+                                            std::pair{"INT.bin", &rom_int}, std::pair{"BRANCH.bin", &branch}}) {
+                auto file = std::ofstream{directory / name, std::ios::binary};
+                file.write(reinterpret_cast<const char *>(rom->data()), static_cast<std::streamsize>(rom->size()));
+            }
+            return directory.string();
+        }
+
+        constexpr static auto size = std::size_t{1} << 13u;
+        constexpr static auto mcc_rst = uint8_t{1u << 2u};
+        constexpr static auto int_address_out = uint8_t{1u << 2u};
+
+        std::vector<uint8_t> g, f, rom_int, branch;
+    };
+
+    auto check(const Microcode &microcode, std::string_view config) -> std::string {
+        return interrupts::check_roms(microcode.write(), *interrupts::parse_config(config)).value_or("");
+    }
+}
+
+TEST_CASE("The microcode check finds an ISR that can't be taken") {
+    CHECK_EQ(check(Microcode{}, "vsync=0 ps2=1 timer=4:100"), "");
+
+    // the fetch holds the latch reset
+    auto reset_fetch = Microcode{};
+    reset_fetch.g[0x12u << 4u] = 0x08u;
+    CHECK_EQ(check(reset_fetch, "ps2=1"), "");
+    CHECK_EQ(check(reset_fetch, "vsync=0"), "line 0: the microcode holds its latch reset while it fetches opcode 12");
+
+    // a line enters blank microcode
+    auto blank_isr = Microcode{};
+    blank_isr.rom_int[0b100u << 8u | 0x40u] = 0xD8u;
+    CHECK_EQ(check(blank_isr, "vsync=2"), "line 2: enters the microcode at d8, which never reads the vector at fff6");
+
+    // the ISR leaves the latch set
+    auto set_latch = Microcode{};
+    set_latch.g[Microcode::isr << 4u | 3u] = 0x08u;
+    CHECK_EQ(check(set_latch, "vsync=0"), "");
+    CHECK_EQ(check(set_latch, "timer=1:100"), "line 1: enters the microcode at f3, which never resets its latch");
+
+    CHECK_EQ(interrupts::check_roms("no such directory", interrupts::Config{.lines = {0u}}),
+             "can't read the microcode in no such directory");
+}
+
+TEST_CASE("The microcode in resources/roms can't take interrupts yet") {
+    // see interrupts.hpp, this fails once the ROMs are fixed and SIM_INTERRUPTS can be used
+    for (auto line = 0u; line < interrupts::line_count; line++) {
+        auto config = interrupts::Config{};
+        config.lines[0] = line;
+        CHECK(interrupts::check_roms(ROMS_DIR, config).has_value());
+    }
+}
@@ -0,0 +1,61 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+#include "mmio.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace {
+    struct Device {
+        std::vector<uint8_t> written{};
+        uint8_t next = 0x40u;
+    };
+
+    using Decoder = mmio::Decoder<Device, 16>;
+
+    auto decoder() -> Decoder {
+        auto io = Decoder{0xFF00u};
+        io.map(0xFF00u, {.write = [](Device &device, uint8_t value) { device.written.push_back(value); }});
+        io.map(0xFF01u, {.read = [](Device &device) -> uint8_t { return device.next++; }});
+        return io;
+    }
+}
+
+TEST_CASE("Only addresses in the window are decoded") {
+    const auto io = decoder();
+    CHECK(io.find(0xFEFFu) == nullptr);
+    CHECK(io.find(0xFF10u) == nullptr);
+    CHECK(io.find(0x0000u) == nullptr);
+    CHECK(io.find(0xFFF2u) == nullptr);
+    CHECK(io.find(0xFF0Fu) != nullptr);
+    CHECK(io.contains(0xFF00u));
+    CHECK_FALSE(io.contains(0xFF10u));
+}
+
+TEST_CASE("Stack and zero page accesses don't reach the window") {
+    const auto io = decoder();
+    CHECK(io.find(0xFF01u, false, true) == io.find(0xFF01u));
+    // a push or pop with the stack counter at 0xFF01
+    CHECK(io.find(0xFF01u, true, true) == nullptr);
+    // a zero page access to 0x01 with 0xFF left in MAR's high byte
+    CHECK(io.find(0xFF01u, false, false) == nullptr);
+
+    // a window in page 0 is reached by zero page accesses
+    const auto low = mmio::Decoder<Device, 16>{0x0000u};
+    CHECK(low.find(0xFF01u, false, false) == low.find(0x0001u));
+    CHECK(low.find(0x0001u, true, false) == nullptr);
+}
+
+TEST_CASE("Registers call their handlers") {
+    const auto io = decoder();
+    auto device = Device{};
+
+    io.find(0xFF00u)->write(device, 'A');
+    CHECK_EQ(device.written.size(), 1u);
+    CHECK_EQ(io.find(0xFF01u)->read(device), 0x40u);
+    CHECK_EQ(io.find(0xFF01u)->read(device), 0x41u);
+
+    // unmapped directions and registers are left to memory
+    CHECK(io.find(0xFF00u)->read == nullptr);
+    CHECK(io.find(0xFF01u)->write == nullptr);
+    CHECK(io.find(0xFF0Fu)->read == nullptr);
+}
@@ -0,0 +1,205 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+#include "ps2.hpp"
+#include "ps2_line.hpp"
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace {
+    // The bytes the keyboard sent before the table, built from key_to_scan_code at runtime
+    auto reference_bytes(KeyboardKey key, bool isRelease) -> std::vector<uint8_t> {
+        if (key == KEY_PRINT_SCREEN) {
+            if (isRelease) {
+                return {0xE0, 0xF0, 0x7C, 0xE0, 0xF0, 0x12};
+            }
+            return {0xE0, 0x12, 0xE0, 0x7C};
+        }
+        if (key == KEY_PAUSE) {
+            if (isRelease) {
+                return {};
+            }
+            return {0xE1, 0x14, 0x77, 0xE1, 0xF0, 0x14, 0xE0, 0x77};
+        }
+
+        auto result = std::vector<uint8_t>{};
+        const auto code = key_to_scan_code(key);
+        if (const auto *value = std::get_if<uint8_t>(&code)) {
+            if (*value == 0u) {
+                return {};
+            }
+            if (isRelease) {
+                result.push_back(0xF0);
+            }
+            result.push_back(*value);
+            return result;
+        }
+        const auto [prefix, value] = std::get<std::pair<uint8_t, uint8_t>>(code);
+        result.push_back(prefix);
+        if (isRelease) {
+            result.push_back(0xF0);
+        }
+        result.push_back(value);
+        return result;
+    }
+
+    auto sequence_bytes(const ps2::Sequence &sequence) -> std::vector<uint8_t> {
+        auto bytes = std::vector<uint8_t>{};
+        for (const auto frame : sequence) {
+            bytes.push_back(ps2::frame_value(frame));
+        }
+        return bytes;
+    }
+}
+
+TEST_CASE("Frames have a start bit, odd parity and a stop bit") {
+    for (auto value = 0u; value < 256u; value++) {
+        const auto frame = ps2::make_frame(static_cast<uint8_t>(value));
+        CAPTURE(value);
+        CHECK_EQ(frame & 1u, 0u);
+        CHECK_EQ(frame >> 10u, 1u);
+        CHECK_EQ(ps2::frame_value(frame), value);
+        // data and parity together have an odd number of ones
+        CHECK_EQ(std::popcount(static_cast<unsigned>(frame >> 1u & 0x1FFu)) % 2, 1);
+    }
+    static_assert(ps2::make_frame(0x00) == 0b11'0000'0000'0u);
+    static_assert(ps2::make_frame(0x1C) == 0b10'0001'1100'0u);
+}
+
+TEST_CASE("The table matches key_to_scan_code for every key") {
+    // past the table as well, those keys send nothing
+    for (auto key = 0u; key < ps2::key_count + 16u; key++) {
+        for (const auto isRelease : {false, true}) {
+            CAPTURE(key);
+            CAPTURE(isRelease);
+            const auto &sequence = ps2::encode_key(static_cast<KeyboardKey>(key), isRelease);
+            CHECK_EQ(sequence_bytes(sequence), reference_bytes(static_cast<KeyboardKey>(key), isRelease));
+        }
+    }
+}
+
+TEST_CASE("Key events that don't fit are dropped whole") {
+    auto keyboard = ps2::Keyboard{};
+
+    // 8 make codes of Pause fill the buffer
+    for (auto i = 0u; i < decltype(keyboard.frames_to_send)::capacity() / 8u; i++) {
+        CHECK(keyboard.send_key(KEY_PAUSE, false));
+    }
+    CHECK_FALSE(keyboard.send_key(KEY_A, false));
+    CHECK_EQ(keyboard.frames_to_send.size(), decltype(keyboard.frames_to_send)::capacity());
+
+    const auto first = keyboard.frames_to_send.pop();
+    REQUIRE(first.has_value());
+    CHECK_EQ(ps2::frame_value(*first), 0xE1u);
+    CHECK_FALSE(keyboard.send_key(KEY_INSERT, false));
+    CHECK(keyboard.send_key(KEY_A, false));
+    CHECK_EQ(keyboard.frames_to_send.size(), decltype(keyboard.frames_to_send)::capacity());
+}
+
+namespace {
+    // Stands in for the CPU's clock domain
+    struct Counter {
+        uint8_t clk = 0u;
+        uint64_t evals = 0u;
+
+        void eval() { evals++; }
+    };
+
+    constexpr uint32_t half_period = 40u;
+}
+
+TEST_CASE("The line driver shifts queued frames out to the receiver") {
+    auto keyboard = ps2::Keyboard{};
+    auto receiver = ps2::Receiver{};
+    auto driver = ps2::LineDriver{&keyboard, &receiver, half_period};
+    auto counter = Counter{};
+    auto cpu_clock = Clock{&counter, 4, 0, true};
+    auto scheduler = ClockScheduler{};
+    scheduler.add_clock(&cpu_clock);
+    scheduler.add_clock(&driver);
+
+    REQUIRE(keyboard.send_key(KEY_INSERT, true));
+    auto bytes = std::vector<uint8_t>{};
+    while (!driver.idle()) {
+        scheduler.advance();
+        if (receiver.interrupt) {
+            bytes.push_back(receiver.read());
+        }
+        REQUIRE_LT(scheduler.time, 1'000'000u);
+    }
+
+    const auto expected = std::vector<uint8_t>{0xE0, 0xF0, 0x70};
+    CHECK_EQ(bytes, expected);
+    CHECK_EQ(driver.frames_sent, 3u);
+    CHECK_EQ(receiver.frame_errors, 0u);
+    CHECK_EQ(receiver.overruns, 0u);
+    // 11 clock cycles per frame, back to back
+    CHECK_EQ(scheduler.time, 3u * 22u * half_period);
+}
+
+TEST_CASE("An idle line driver never ticks") {
+    auto keyboard = ps2::Keyboard{};
+    auto receiver = ps2::Receiver{};
+    auto driver = ps2::LineDriver{&keyboard, &receiver, half_period};
+    auto counter = Counter{};
+    auto cpu_clock = Clock{&counter, 4, 0, true};
+    auto scheduler = ClockScheduler{};
+    scheduler.add_clock(&cpu_clock);
+    scheduler.add_clock(&driver);
+
+    CHECK_EQ(driver.get_time_till_next_tick(), std::numeric_limits<uint32_t>::max());
+    for (auto i = 0u; i < 1000u; i++) {
+        scheduler.advance();
+    }
+    // every advance was one CPU clock edge
+    CHECK_EQ(scheduler.time, 4000u);
+    CHECK_EQ(driver.frames_sent, 0u);
+    CHECK_EQ(receiver.ps2_clk, 1u);
+
+    // picks up a key event queued in between
+    REQUIRE(keyboard.send_key(KEY_A, false));
+    CHECK_EQ(driver.get_time_till_next_tick(), half_period);
+    while (!receiver.interrupt) {
+        scheduler.advance();
+        REQUIRE_LT(scheduler.time, 10'000u);
+    }
+    CHECK_EQ(receiver.read(), 0x1Cu);
+}
+
+TEST_CASE("The line driver is only scheduled while it sends") {
+    auto keyboard = ps2::Keyboard{};
+    auto receiver = ps2::Receiver{};
+    auto driver = ps2::LineDriver{&keyboard, &receiver, half_period};
+    auto counter = Counter{};
+    auto cpu_clock = Clock{&counter, 4, 0, true};
+    auto scheduler = ClockScheduler{};
+    scheduler.add_clock(&cpu_clock);
+
+    driver.schedule(scheduler);
+    CHECK_EQ(scheduler.clocks.size(), 1u);
+
+    REQUIRE(keyboard.send_key(KEY_A, false));
+    driver.schedule(scheduler);
+    CHECK_EQ(scheduler.clocks.size(), 2u);
+    // once is enough
+    driver.schedule(scheduler);
+    CHECK_EQ(scheduler.clocks.size(), 2u);
+
+    while (scheduler.clocks.size() == 2u) {
+        scheduler.advance();
+        driver.schedule(scheduler);
+        REQUIRE_LT(scheduler.time, 10'000u);
+    }
+    CHECK_EQ(receiver.read(), 0x1Cu);
+    CHECK(driver.idle());
+    // 11 clock cycles and nothing after
+    CHECK_EQ(scheduler.time, 22u * half_period);
+    CHECK_EQ(scheduler.clocks.front(), &cpu_clock);
+}
+
+TEST_CASE("Keyboard clock rates") {
+    // the VGA pixel clock drives the simulator's time
+    CHECK_EQ(ps2::clock_half_period(25'175'000u), 1007u);
+    CHECK_EQ(ps2::clock_half_period(25'175'000u, 10'000u), 1258u);
+}
@@ -0,0 +1,78 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+#include "ring_buffer.hpp"
+#include "sim_log.hpp"
+#include <cstdio>
+#include <vector>
+
+TEST_CASE("Ring buffer keeps FIFO order and rejects pushes when full") {
+    RingBuffer<int, 4> buffer;
+
+    for (int i = 0; i < 4; i++) {
+        CHECK(buffer.push(i));
+    }
+    CHECK_FALSE(buffer.push(4));
+    CHECK_EQ(buffer.size(), 4);
+
+    CHECK_EQ(buffer.pop(), 0);
+    CHECK(buffer.push(4));
+
+    const auto expected = std::vector<int>{1, 2, 3, 4};
+    std::vector<int> drained;
+    CHECK_EQ(buffer.drain([&](int value) { drained.push_back(value); }), 4);
+    CHECK(drained == expected);
+    CHECK(buffer.empty());
+    CHECK_FALSE(buffer.pop().has_value());
+}
+
+TEST_CASE("Disabled sources are not recorded") {
+    sim_log::discard();
+    sim_log::set_mask(sim_log::mask_of(sim_log::Source::RamWrite));
+
+    sim_log_event(static_cast<int>(sim_log::Source::IrLoad), 1, 0xAD, 0);
+    sim_log_event(static_cast<int>(sim_log::Source::RamWrite), 2, 0x1234, 0xBE);
+    sim_log_event(static_cast<int>(sim_log::Source::MarLoad), 3, 0xDEAD, 0);
+
+    auto *file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    CHECK_EQ(sim_log::drain(file), 1);
+
+    std::rewind(file);
+    sim_log::Record record{};
+    REQUIRE_EQ(std::fread(&record, sizeof(record), 1, file), 1);
+    CHECK_EQ(record.timestamp, 2);
+    CHECK_EQ(record.a, 0x1234);
+    CHECK_EQ(record.b, 0xBE);
+    CHECK_EQ(record.source, static_cast<uint8_t>(sim_log::Source::RamWrite));
+    std::fclose(file);
+
+    sim_log::set_mask(0u);
+}
+
+TEST_CASE("Records are stamped from the time source when one is set") {
+    sim_log::discard();
+    sim_log::set_mask(sim_log::all_sources);
+
+    auto time = uint64_t{1234u};
+    sim_log::set_time_source(&time);
+    sim_log_event(static_cast<int>(sim_log::Source::IrLoad), 0, 0xAD, 0);
+    time = 5678u;
+    sim_log_event(static_cast<int>(sim_log::Source::IrLoad), 0, 0xAE, 0);
+    sim_log::set_time_source(nullptr);
+    sim_log_event(static_cast<int>(sim_log::Source::IrLoad), 9, 0xAF, 0);
+
+    auto *file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    CHECK_EQ(sim_log::drain(file), 3);
+
+    std::rewind(file);
+    sim_log::Record records[3]{};
+    REQUIRE_EQ(std::fread(records, sizeof(sim_log::Record), 3, file), 3);
+    CHECK_EQ(records[0].timestamp, 1234u);
+    CHECK_EQ(records[1].timestamp, 5678u);
+    // back to the RTL's $time
+    CHECK_EQ(records[2].timestamp, 9u);
+    std::fclose(file);
+
+    sim_log::set_mask(0u);
+}
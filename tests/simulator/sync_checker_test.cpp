@@ -0,0 +1,167 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+#include "sync_checker.hpp"
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <variant>
+#include <vector>
+
+namespace {
+    // Small enough to build frames tick by tick
+    constexpr auto tiny = VGATiming{8u, 2u, 3u, 1u, 4u, 1u, 2u, 1u, true, true};
+    using Checker = SyncChecker<tiny>;
+
+    // Levels of a correct frame, `broken` can change the hsync level of any tick
+    using Corruption = std::function<bool(uint32_t line, uint32_t column, bool hsync)>;
+
+    auto feed_frame(Checker &checker, const Corruption &broken = {}) -> std::optional<VGASimulatorError> {
+        if (!checker.begin_frame()) {
+            return std::nullopt;
+        }
+        for (auto line = 0u; line < Checker::frame_lines; line++) {
+            const auto vsync = line >= Checker::vsync_start && line < Checker::vsync_start + tiny.v_sync_pulse_width;
+            for (auto column = 0u; column < tiny.h_total(); column++) {
+                auto hsync = column >= Checker::hsync_start && column < Checker::hsync_start + tiny.h_sync_pulse_width;
+                if (broken) {
+                    hsync = broken(line, column, hsync);
+                }
+                checker.sample(hsync, vsync);
+            }
+        }
+        return checker.end_frame();
+    }
+}
+
+TEST_CASE("correct frames have no violations") {
+    auto checker = Checker{};
+    for (auto i = 0; i < 3; i++) {
+        CHECK_FALSE(feed_frame(checker).has_value());
+    }
+    CHECK_EQ(checker.result().total(), 0u);
+    CHECK_EQ(checker.result().frames_checked, 3u);
+    CHECK_FALSE(checker.result().first.has_value());
+}
+
+TEST_CASE("every violation is counted, the frame goes on") {
+    auto checker = Checker{};
+
+    // lines 1 and 3 lose the last tick of their pulse, line 2 has no pulse at all
+    const auto error = feed_frame(checker, [](uint32_t line, uint32_t column, bool hsync) {
+        if (line == 2u) {
+            return false;
+        }
+        if ((line == 1u || line == 3u) && column == Checker::hsync_start + tiny.h_sync_pulse_width - 1u) {
+            return false;
+        }
+        return hsync;
+    });
+
+    REQUIRE(error.has_value());
+    CHECK(std::holds_alternative<IncorrectPulseWidth>(*error));
+    CHECK_EQ(checker.result().count<IncorrectPulseWidth>(), 2u);
+    CHECK_EQ(checker.result().count<HSyncUndetected>(), 1u);
+    CHECK_EQ(checker.result().total(), 3u);
+
+    // the next frame is read from its start again
+    CHECK_FALSE(feed_frame(checker).has_value());
+    CHECK_EQ(checker.result().total(), 3u);
+    CHECK_EQ(checker.result().first_frame, 0u);
+}
+
+TEST_CASE("late and repeated pulses") {
+    auto checker = Checker{};
+
+    const auto error = feed_frame(checker, [](uint32_t line, uint32_t column, bool hsync) {
+        if (line == 0u) {
+            // one tick late
+            return column > Checker::hsync_start && column <= Checker::hsync_start + tiny.h_sync_pulse_width;
+        }
+        if (line == 1u && column == 0u) {
+            return true;
+        }
+        return hsync;
+    });
+
+    REQUIRE(error.has_value());
+    CHECK(std::holds_alternative<IncorrectSyncTiming>(*error));
+    const auto &timing = std::get<IncorrectSyncTiming>(*error);
+    CHECK(timing.is_hsync);
+    CHECK_EQ(timing.expected, Checker::hsync_start);
+    CHECK_EQ(timing.actual, Checker::hsync_start + 1u);
+
+    // the pulse at column 0 comes first, so line 1 has the wrong start and width as well
+    CHECK_EQ(checker.result().count<MultiplePulsesDetected>(), 1u);
+    CHECK_EQ(checker.result().count<IncorrectSyncTiming>(), 2u);
+    CHECK_EQ(checker.result().count<IncorrectPulseWidth>(), 1u);
+}
+
+TEST_CASE("missing vsync") {
+    auto checker = Checker{};
+    REQUIRE(checker.begin_frame());
+    for (auto line = 0u; line < Checker::frame_lines; line++) {
+        for (auto column = 0u; column < tiny.h_total(); column++) {
+            checker.sample(column >= Checker::hsync_start && column < Checker::hsync_start + tiny.h_sync_pulse_width,
+                           false);
+        }
+    }
+    const auto error = checker.end_frame();
+    REQUIRE(error.has_value());
+    CHECK(std::holds_alternative<VSyncUndetected>(*error));
+    CHECK_EQ(checker.result().total(), 1u);
+}
+
+TEST_CASE("a short frame is a row timing violation") {
+    auto checker = Checker{};
+    REQUIRE(checker.begin_frame());
+    checker.sample(false, false);
+    const auto error = checker.end_frame();
+    REQUIRE(error.has_value());
+    CHECK(std::holds_alternative<IncorrectRowTiming>(*error));
+}
+
+TEST_CASE("validation levels") {
+    const auto checked_frames = [](SyncValidation validation) {
+        auto checker = Checker{};
+        checker.validation = validation;
+        auto checked = std::vector<int>{};
+        for (auto frame = 0; frame < 7; frame++) {
+            if (checker.begin_frame()) {
+                checked.push_back(frame);
+                checker.end_frame();
+            }
+        }
+        return checked;
+    };
+
+    const auto all = std::vector{0, 1, 2, 3, 4, 5, 6};
+    const auto every_third = std::vector{0, 3, 6};
+    const auto first = std::vector{0};
+    CHECK(checked_frames({}) == all);
+    CHECK(checked_frames({.level = SyncValidation::Level::EveryNthFrame, .interval = 3u}) == every_third);
+    CHECK(checked_frames({.level = SyncValidation::Level::FirstFrame}) == first);
+
+    auto checker = Checker{};
+    checker.validation.level = SyncValidation::Level::FirstFrame;
+    CHECK_FALSE(feed_frame(checker).has_value());
+    CHECK_FALSE(checker.begin_frame());
+    CHECK_EQ(checker.result().frames_skipped, 1u);
+
+    // sync() resets the checker, the next frame is the first one again
+    checker.reset();
+    CHECK(checker.begin_frame());
+}
+
+TEST_CASE("parse_sync_validation") {
+    CHECK(parse_sync_validation("all")->level == SyncValidation::Level::EveryFrame);
+    CHECK(parse_sync_validation("first")->level == SyncValidation::Level::FirstFrame);
+
+    const auto every_60 = parse_sync_validation("60");
+    REQUIRE(every_60.has_value());
+    CHECK(every_60->level == SyncValidation::Level::EveryNthFrame);
+    CHECK_EQ(every_60->interval, 60u);
+
+    CHECK_FALSE(parse_sync_validation("0").has_value());
+    CHECK_FALSE(parse_sync_validation("6x").has_value());
+    CHECK_FALSE(parse_sync_validation("").has_value());
+}
@@ -0,0 +1,123 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+#include "trace.hpp"
+#include "trigger.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace {
+    constexpr auto ir_load = uint64_t{1} << 39;
+    constexpr auto mem_in = uint64_t{1} << 32;
+    constexpr auto int_address_out = uint64_t{1} << 47;
+
+    // A CPU that fetches one 1-byte instruction every 4 samples (2 cycles), PC counts up from 0
+    auto fake_sample(uint64_t time) -> trace::CpuSample {
+        const auto step = time % 4u;
+        return {
+            .time = time,
+            .signals = step == 2u || step == 3u ? ir_load : mem_in,
+            .addr_bus = static_cast<uint16_t>(time),
+            .pc = static_cast<uint16_t>(time / 4u),
+            .bus = static_cast<uint8_t>(0xE0u + time / 4u),
+            .a = 0,
+            .b = 0,
+            .flags = 0,
+        };
+    }
+
+    auto written_times(const trace::CpuRecorder &recorder) -> std::vector<uint64_t> {
+        auto times = std::vector<uint64_t>{};
+        recorder.window.for_each([&](const trace::CpuSample &sample) {
+            if (sample.time >= recorder.first_time) {
+                times.push_back(sample.time);
+            }
+        });
+        return times;
+    }
+}
+
+TEST_CASE("Window keeps the newest values, oldest first") {
+    auto window = trace::Window<int>{3};
+    CHECK_EQ(window.capacity(), 4);
+
+    for (int i = 0; i < 6; i++) {
+        window.record(i);
+    }
+
+    const auto expected = std::vector<int>{2, 3, 4, 5};
+    auto values = std::vector<int>{};
+    window.for_each([&](int value) { values.push_back(value); });
+    CHECK(values == expected);
+}
+
+TEST_CASE("Trigger configs are parsed") {
+    const auto config = trace::parse_trigger_config("start=signal:INT_ADDRESS_OUT=1 stop=opcode:f4 pre=8 post=4");
+    REQUIRE(config.has_value());
+    CHECK(config->start.field == trace::Trigger::Field::Signals);
+    CHECK_EQ(config->start.mask, int_address_out);
+    CHECK_EQ(config->start.low, int_address_out);
+    REQUIRE(config->stop.has_value());
+    CHECK(config->stop->field == trace::Trigger::Field::Opcode);
+    CHECK_EQ(config->stop->low, 0xF4);
+    CHECK_EQ(config->pre_cycles, 8);
+    CHECK_EQ(config->post_cycles, 4);
+
+    const auto pc = trace::parse_trigger("pc:a0b0-a0bf");
+    REQUIRE(pc.has_value());
+    CHECK(pc->field == trace::Trigger::Field::Pc);
+    CHECK_EQ(pc->low, 0xA0B0);
+    CHECK_EQ(pc->high, 0xA0BF);
+
+    const auto signal = trace::parse_trigger("signal:MEM_IN=0");
+    REQUIRE(signal.has_value());
+    CHECK_EQ(signal->mask, mem_in);
+    CHECK_EQ(signal->low, 0);
+
+    CHECK_FALSE(trace::parse_trigger_config("stop=pc:10").has_value());
+    CHECK_FALSE(trace::parse_trigger_config("start=pc:zz").has_value());
+    CHECK_FALSE(trace::parse_trigger("signal:NOT_A_SIGNAL=1").has_value());
+}
+
+TEST_CASE("PC triggers only fire on fetches and keep the pre and post cycles") {
+    auto config = trace::TriggerConfig{};
+    config.start = *trace::parse_trigger("pc:5");
+    config.pre_cycles = 2;
+    config.post_cycles = 3;
+
+    auto captured = std::vector<std::vector<uint64_t>>{};
+    auto recorder = trace::TriggeredRecorder{"cpu", config, "unused"};
+    recorder.on_capture = [&](const trace::CpuRecorder &window) { captured.push_back(written_times(window)); };
+
+    for (uint64_t time = 0; time < 64; time++) {
+        recorder.record(fake_sample(time));
+    }
+
+    // pc 5 is fetched at time 22, 2 cycles before and 3 after
+    REQUIRE_EQ(captured.size(), 1);
+    CHECK_EQ(captured[0].front(), 18);
+    CHECK_EQ(captured[0].back(), 28);
+    CHECK_FALSE(recorder.is_capturing());
+}
+
+TEST_CASE("Captures run from the start to the stop trigger and rearm") {
+    auto config = trace::TriggerConfig{};
+    config.start = *trace::parse_trigger("opcode:e2");
+    config.stop = trace::parse_trigger("opcode:e4");
+    config.pre_cycles = 0;
+    config.post_cycles = 0;
+
+    auto captured = std::vector<std::vector<uint64_t>>{};
+    auto recorder = trace::TriggeredRecorder{"cpu", config, "unused"};
+    recorder.on_capture = [&](const trace::CpuRecorder &window) { captured.push_back(written_times(window)); };
+
+    for (uint64_t time = 0; time < 24; time++) {
+        recorder.record(fake_sample(time));
+        if (time == 12) {
+            CHECK(recorder.is_capturing());
+        }
+    }
+
+    REQUIRE_EQ(captured.size(), 1);
+    CHECK_EQ(captured[0].front(), 10);
+    CHECK_EQ(captured[0].back(), 18);
+}
@@ -0,0 +1,121 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+#include "video_capture.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr uint16_t width = 80u;
+    constexpr uint16_t height = 60u;
+
+    // Text-like content: runs of background with a few glyph pixels, changing every frame
+    auto test_frame(uint64_t index) -> std::vector<uint16_t> {
+        auto pixels = std::vector<uint16_t>(std::size_t{width} * height, video_capture::pack(0, 0, 0));
+        for (auto i = std::size_t{0}; i < pixels.size(); i += 7u + index % 5u) {
+            pixels[i] = video_capture::pack(0xf0, static_cast<uint8_t>(index * 16u), 0x80);
+        }
+        return pixels;
+    }
+}
+
+TEST_CASE("pack keeps the 4 bits per channel of the VGA output") {
+    CHECK_EQ(video_capture::pack(0xf0, 0x80, 0x10), 0xf81u);
+    CHECK_EQ(video_capture::pack(0x00, 0x00, 0x00), 0x000u);
+}
+
+TEST_CASE("Runs are smaller than the frame") {
+    const auto pixels = test_frame(0);
+    auto encoded = std::vector<uint8_t>{};
+    video_capture::encode_frame(pixels.data(), pixels.size(), encoded);
+    CHECK_LT(encoded.size(), pixels.size() * sizeof(uint16_t));
+}
+
+TEST_CASE("Frames written by the background thread read back unchanged") {
+    const auto path = std::string{"video_capture_test.vidcap"};
+    constexpr auto frames = 40u;
+
+    {
+        auto writer = video_capture::Writer{path, width, height};
+        REQUIRE(writer.is_open());
+        for (auto i = 0u; i < frames; i++) {
+            if (i % 10u == 9u) {
+                writer.repeat_frame();
+                continue;
+            }
+            auto *buffer = writer.begin_frame();
+            REQUIRE(buffer != nullptr);
+            const auto pixels = test_frame(i);
+            std::ranges::copy(pixels, buffer);
+            writer.end_frame();
+        }
+        CHECK_EQ(writer.frames(), frames);
+        CHECK_EQ(writer.dropped(), 0u);
+    }
+
+    const auto video = video_capture::read(path);
+    REQUIRE(video.has_value());
+    CHECK_EQ(video->width, width);
+    CHECK_EQ(video->height, height);
+    REQUIRE_EQ(video->frames.size(), frames);
+    for (auto i = 0u; i < frames; i++) {
+        CHECK_EQ(video->frames[i].index, i);
+        const auto expected = test_frame(i % 10u == 9u ? i - 1u : i);
+        CHECK(video->frames[i].pixels == expected);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Dropped frames leave gaps in the frame index") {
+    const auto path = std::string{"video_capture_drop_test.vidcap"};
+    auto written = uint64_t{0};
+    auto dropped = uint64_t{0};
+
+    {
+        auto writer = video_capture::Writer{path, width, height, video_capture::Policy::Drop};
+        REQUIRE(writer.is_open());
+        const auto pixels = test_frame(3);
+        for (auto i = 0u; i < 2000u; i++) {
+            if (auto *buffer = writer.begin_frame()) {
+                std::ranges::copy(pixels, buffer);
+            }
+            writer.end_frame();
+            // a repeat of a dropped frame is dropped as well
+            writer.repeat_frame();
+        }
+        CHECK_EQ(writer.frames(), 4000u);
+        dropped = writer.dropped();
+    }
+
+    const auto video = video_capture::read(path);
+    REQUIRE(video.has_value());
+    written = video->frames.size();
+    CHECK_EQ(written + dropped, 4000u);
+    for (auto i = std::size_t{1}; i < video->frames.size(); i++) {
+        CHECK_LT(video->frames[i - 1u].index, video->frames[i].index);
+    }
+    const auto expected = test_frame(3);
+    for (const auto &frame : video->frames) {
+        CHECK(frame.pixels == expected);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Truncated recordings are rejected") {
+    const auto path = std::string{"video_capture_truncated_test.vidcap"};
+    {
+        auto writer = video_capture::Writer{path, width, height};
+        std::ranges::copy(test_frame(1), writer.begin_frame());
+        writer.end_frame();
+    }
+
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3u);
+
+    CHECK_FALSE(video_capture::read(path).has_value());
+    std::remove(path.c_str());
+}
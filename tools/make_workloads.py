@@ -0,0 +1,356 @@
+from argparse import ArgumentParser
+from pathlib import Path
+
+# Generates the guest workloads in resources/workloads for bench/workloads.cpp (sim_workloads).
+#
+# Every workload is assembled from the instructions the microcode ROMs in resources/roms implement, executed on a
+# small model of the CPU to get the expected memory contents and the expected cycle count. Step counts are read
+# from the ROMs, so regenerate the workloads whenever the microcode changes.
+
+ROOT = Path(__file__).resolve().parent.parent
+
+# Memory mapped devices of sim_workloads, keep in sync with bench/guest_machine.hpp
+GPU_PORT = 0xFF00
+KEYBOARD_PORT = 0xFF01
+KEYBOARD_STATUS = 0xFF02
+GPU_CURSOR = 0xFF03
+GPU_DISPLAY = 0xFF04
+GPU_CLEAR = 0xFF05
+GPU_STATUS = 0xFF06
+CYCLE_COUNTER = 0xFF08
+
+# Scan code set 2 of the keys keyboard_echo types, keep in sync with simulator/ps2/ps2Lookup.hpp. The raylib key code
+# of a letter, digit or space is its ASCII code.
+SCAN_CODES = {"E": 0x24, "C": 0x21, "H": 0x33, "O": 0x44, " ": 0x29, "1": 0x16, "2": 0x1E, "3": 0x26}
+RELEASE_PREFIX = 0xF0
+
+# Signal bits, see cpu/include/signals.v
+PC_TICK = 22
+MCC_RST = 41
+
+# name: (opcode, operand bytes)
+OPCODES = {
+    "mov_a_b": (0x01, 0),
+    "mov_b_a": (0x06, 0),
+    "mov_a_imm": (0x15, 1),
+    "mov_b_imm": (0x16, 1),
+    "mov_a_abs": (0x19, 2),
+    "mov_b_abs": (0x1B, 2),
+    "mov_abs_a": (0x2B, 2),
+    "mov_abs_b": (0x2D, 2),
+    "mov_abs_imm": (0x31, 3),
+    "add_a_b": (0x51, 0),
+    "sub_a_b": (0x56, 0),
+    "sar_a": (0x60, 0),
+    "and_a_b": (0x79, 0),
+    "xor_a_b": (0x7E, 0),
+    "jmp": (0xB2, 2),
+    "nop": (0xEF, 0),
+}
+
+
+class Microcode:
+    def __init__(self, roms):
+        self.roms = {name: (roms / "{}.bin".format(name)).read_bytes() for name in "A B C D E F G INT BRANCH".split()}
+
+    def signals(self, opcode, step):
+        inst = self.roms["BRANCH"][self.roms["INT"][opcode] << 5]
+        index = (inst << 4) | step
+        a, b, c, d, e, f, g = (self.roms[name][index] for name in "ABCDEFG")
+        return a | b << 8 | c << 16 | d << 24 | (e & 0x7F) << 32 | f << 39 | ((g >> 2) & 1) << 47
+
+    def steps(self, opcode):
+        """Microcode steps of `opcode` including the fetch, raises for instructions the ROMs leave blank"""
+        for step in range(16):
+            if self.signals(opcode, step) >> MCC_RST & 1:
+                return step + 1
+        raise ValueError("opcode {:02x} never resets the microcode counter".format(opcode))
+
+    def first_pc_tick(self, opcode):
+        return next(step for step in range(16) if self.signals(opcode, step) >> PC_TICK & 1)
+
+
+class Program:
+    def __init__(self, origin=0x0000):
+        self.origin = origin
+        self.code = bytearray()
+        # (address, opcode) of every instruction
+        self.instructions = []
+
+    @property
+    def here(self):
+        return self.origin + len(self.code)
+
+    def emit(self, name, *operands):
+        opcode, operand_bytes = OPCODES[name]
+        encoded = []
+        if operand_bytes == 1:
+            encoded = [operands[0] & 0xFF]
+        elif operand_bytes == 2:
+            encoded = [operands[0] >> 8, operands[0] & 0xFF]
+        elif operand_bytes == 3:
+            encoded = [operands[0] >> 8, operands[0] & 0xFF, operands[1] & 0xFF]
+        self.instructions.append((self.here, opcode))
+        self.code += bytes([opcode] + encoded)
+
+    def __getattr__(self, name):
+        if name not in OPCODES:
+            raise AttributeError(name)
+        return lambda *operands: self.emit(name, *operands)
+
+
+class Model:
+    """Instruction level model of the CPU, `run` stops when the PC reaches `end`"""
+
+    def __init__(self, microcode):
+        self.microcode = microcode
+        self.memory = bytearray(0x10000)
+        self.a = 0
+        self.b = 0
+        self.pc = 0
+        self.cycles = 0
+
+    def load(self, address, data):
+        self.memory[address:address + len(data)] = data
+
+    def fetch(self):
+        value = self.memory[self.pc]
+        self.pc = (self.pc + 1) & 0xFFFF
+        return value
+
+    def fetch_word(self):
+        return self.fetch() << 8 | self.fetch()
+
+    def run(self, end):
+        while self.pc != end:
+            opcode = self.fetch()
+            self.cycles += self.microcode.steps(opcode)
+            self.execute(opcode)
+        # the runner stops once it fetched the `jmp end`
+        self.cycles += self.microcode.first_pc_tick(self.memory[end]) + 1
+
+    def execute(self, opcode):
+        if opcode == 0x01:
+            self.a = self.b
+        elif opcode == 0x06:
+            self.b = self.a
+        elif opcode == 0x15:
+            self.a = self.fetch()
+        elif opcode == 0x16:
+            self.b = self.fetch()
+        elif opcode == 0x19:
+            self.a = self.memory[self.fetch_word()]
+        elif opcode == 0x1B:
+            self.b = self.memory[self.fetch_word()]
+        elif opcode == 0x2B:
+            self.memory[self.fetch_word()] = self.a
+        elif opcode == 0x2D:
+            self.memory[self.fetch_word()] = self.b
+        elif opcode == 0x31:
+            address = self.fetch_word()
+            self.memory[address] = self.fetch()
+        elif opcode == 0x51:
+            self.a = (self.a + self.b) & 0xFF
+        elif opcode == 0x56:
+            self.a = (self.a - self.b) & 0xFF
+        elif opcode == 0x60:
+            self.a = self.a >> 1  # the workloads mask the result, so an arithmetic shift gives the same values
+        elif opcode == 0x79:
+            self.a &= self.b
+        elif opcode == 0x7E:
+            self.a ^= self.b
+        elif opcode == 0xB2:
+            self.pc = self.fetch_word()
+        elif opcode != 0xEF:
+            raise ValueError("unsupported opcode {:02x} at {:04x}".format(opcode, self.pc - 1))
+
+
+class Workload:
+    def __init__(self, name, description):
+        self.name = name
+        self.description = description
+        self.program = Program()
+        self.data = {}
+        self.expect = {}
+        self.gpu_text = b""
+        self.keys = []
+        self.end = None
+        self.run = None
+
+    def finish(self):
+        self.end = self.program.here
+        self.program.jmp(self.end)
+
+    def write(self, path, microcode):
+        # the model only runs workloads with an `end`, every instruction is checked against the ROMs here
+        for address, opcode in self.program.instructions:
+            try:
+                microcode.steps(opcode)
+            except ValueError as error:
+                raise ValueError("{}: {} at {:04x}".format(self.name, error, address)) from None
+
+        model = Model(microcode)
+        model.load(self.program.origin, self.program.code)
+        for address, data in self.data.items():
+            model.load(address, data)
+
+        lines = ["# {}".format(self.description), "# generated by tools/make_workloads.py, do not edit", ""]
+        lines += chunked("load", self.program.origin, self.program.code)
+        for address, data in self.data.items():
+            lines += chunked("load", address, data)
+
+        if self.end is not None:
+            model.run(self.end)
+            lines += ["end {:04x}".format(self.end), "cycles {}".format(model.cycles)]
+            for address, length in self.expect.items():
+                lines += chunked("expect", address, model.memory[address:address + length])
+        else:
+            lines.append("run {}".format(self.run))
+
+        for cycle, key in self.keys:
+            lines.append("key {} {:x}".format(cycle, key))
+        if self.gpu_text:
+            lines += chunked("gpu_text", None, self.gpu_text)
+
+        path.write_text("\n".join(lines) + "\n")
+
+
+def chunked(keyword, address, data, width=16):
+    lines = []
+    for offset in range(0, len(data), width):
+        chunk = " ".join("{:02x}".format(b) for b in data[offset:offset + width])
+        if address is None:
+            lines.append("{} {}".format(keyword, chunk))
+        else:
+            lines.append("{} {:04x} {}".format(keyword, address + offset, chunk))
+    return lines
+
+
+def memcpy():
+    workload = Workload("memcpy", "memcpy: copies 64 bytes from 0x2000 to 0x2100, one absolute load and store per byte")
+    source, destination, length = 0x2000, 0x2100, 64
+
+    workload.data[source] = bytes((i * 37 + 11) & 0xFF for i in range(length))
+    for i in range(length):
+        workload.program.mov_a_abs(source + i)
+        workload.program.mov_abs_a(destination + i)
+    workload.finish()
+
+    workload.expect[destination] = length
+    return workload
+
+
+def bubble_sort():
+    workload = Workload("bubble_sort", "bubble_sort: sorts 8 bytes at 0x2000 with a fully unrolled, branch free bubble sort")
+    array, length = 0x2000, 8
+    mask, delta, high = 0x2010, 0x2011, 0x2012
+    p = workload.program
+
+    # values stay below 0x80 so x - y never overflows and bit 7 of it is (x < y)
+    workload.data[array] = bytes([0x5A, 0x03, 0x7F, 0x21, 0x00, 0x44, 0x21, 0x10])
+
+    def compare_exchange(x, y):
+        p.mov_a_abs(x), p.mov_b_abs(y), p.sub_a_b()
+        for _ in range(7):
+            p.sar_a()
+        p.mov_b_imm(0x01), p.and_a_b()
+        p.mov_b_a(), p.mov_a_imm(0x00), p.sub_a_b()
+        p.mov_abs_a(mask)
+
+        p.mov_a_abs(x), p.mov_b_abs(y), p.sub_a_b()
+        p.mov_b_abs(mask), p.and_a_b()
+        p.mov_abs_a(delta)
+
+        p.mov_a_abs(x), p.mov_b_abs(delta), p.sub_a_b()
+        p.mov_abs_a(high)
+        p.mov_a_abs(y), p.add_a_b()
+        p.mov_abs_a(x)
+        p.mov_a_abs(high), p.mov_abs_a(y)
+
+    for i in range(length - 1):
+        for j in range(length - 1 - i):
+            compare_exchange(array + j, array + j + 1)
+    workload.finish()
+
+    workload.expect[array] = length
+    return workload
+
+
+def gpu_text():
+    workload = Workload("gpu_text", "gpu_text: writes a line of text to the GPU port at 0x{:04x}".format(GPU_PORT))
+    text = b"Hello from the 8-bit CPU!"
+
+    for c in text:
+        workload.program.mov_abs_imm(GPU_PORT, c)
+    workload.finish()
+
+    workload.gpu_text = text
+    return workload
+
+
+def keyboard_echo():
+    workload = Workload("keyboard_echo", "keyboard_echo: polls the keyboard status at 0x{:04x} and echoes every byte the "
+                        "PS/2 keyboard sends to the GPU port".format(KEYBOARD_STATUS))
+    text = "ECHO 123"
+    p = workload.program
+
+    # The ROMs have no conditional jumps, so the loop patches the address of its read instead: the keyboard port
+    # while a byte is waiting, a zero byte in memory otherwise. The port is only read when a byte is there, one that
+    # arrives during the iteration is picked up by the next one. A 0 is never sent to the GPU.
+    zero = 0x2001
+    workload.data[zero] = bytes([0x00])
+    assert zero & 0xFF == KEYBOARD_PORT & 0xFF
+
+    loop = p.here
+    p.mov_a_abs(KEYBOARD_STATUS)
+    p.mov_b_a(), p.mov_a_imm(0x00), p.sub_a_b()
+    p.mov_b_imm((KEYBOARD_PORT >> 8) - (zero >> 8)), p.and_a_b()
+    p.mov_b_imm(zero >> 8), p.add_a_b()
+    # the high byte of the next instruction's address
+    p.mov_abs_a(p.here + 4)
+    p.mov_a_abs(zero)
+    p.mov_abs_a(GPU_PORT)
+    p.jmp(loop)
+
+    # every key is pressed and released, three PS/2 frames of about 5500 cycles each, so one key is sent before the
+    # next one is queued
+    interval = 20000
+    workload.keys = [(200 + i * interval, ord(c)) for i, c in enumerate(text)]
+    workload.run = workload.keys[-1][0] + interval
+    workload.gpu_text = bytes(b for c in text for b in (SCAN_CODES[c], RELEASE_PREFIX, SCAN_CODES[c]))
+    return workload
+
+
+def alu_chain():
+    workload = Workload("alu_chain", "alu_chain: a long, unrolled chain of register to register ALU operations")
+    p = workload.program
+
+    # a = 3 * a ^ k + k with a different k every step, A is stored every 16 steps
+    p.mov_a_imm(0x01)
+    for i in range(256):
+        p.mov_b_a(), p.add_a_b(), p.add_a_b()
+        p.mov_b_imm(i * 29 + 7), p.xor_a_b(), p.add_a_b()
+        if i % 16 == 15:
+            p.mov_abs_a(0x2000 + i // 16)
+    p.mov_abs_a(0x2010)
+    workload.finish()
+
+    workload.expect[0x2000] = 17
+    return workload
+
+
+WORKLOADS = [memcpy, bubble_sort, gpu_text, keyboard_echo, alu_chain]
+
+if __name__ == "__main__":
+    parser = ArgumentParser(description="Generates the sim_workloads guest programs with their expected results")
+    parser.add_argument("--roms", default=ROOT / "resources" / "roms", type=Path, help="Microcode ROM directory")
+    parser.add_argument("--output", default=ROOT / "resources" / "workloads", type=Path, help="Output directory")
+    args = parser.parse_args()
+
+    microcode = Microcode(args.roms)
+    args.output.mkdir(parents=True, exist_ok=True)
+
+    for make in WORKLOADS:
+        workload = make()
+        workload.write(args.output / "{}.workload".format(workload.name), microcode)
+        print("{:<16} {:>5} bytes".format(workload.name, len(workload.program.code)))
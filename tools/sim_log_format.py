@@ -0,0 +1,41 @@
+from argparse import ArgumentParser
+from pathlib import Path
+import struct
+
+# Formats binary logs written by `sim_log::FileSink` (simulator/log/sim_log.hpp) into text
+
+MAGIC = b"SIMLOG01"
+RECORD = struct.Struct("<QIHBx")
+
+# Keep in sync with `sim_log::Source`
+FORMATS = {
+    0: ("ir", lambda a, b: "data = {:02x}".format(a & 0xFF)),
+    1: ("ram", lambda a, b: "wrote = {:02x} @ {:05x}".format(b & 0xFF, a)),
+    2: ("mem", lambda a, b: "mar = {:04x}".format(a & 0xFFFF)),
+    3: ("mem", lambda a, b: "mbr = {:02x}".format(a & 0xFF)),
+    4: ("gpu ram", lambda a, b: "wrote {:02x}h to {:04x}h".format(b & 0xFF, a)),
+    5: ("gpu", lambda a, b: "write cursor moved cursor = {:04x}h".format(a)),
+}
+
+parser = ArgumentParser(description="Converts binary simulator logs to text")
+parser.add_argument("input", help="Path to the binary log")
+parser.add_argument("--sources", dest="sources", default=None, help="Comma separated list of source ids to print")
+
+args = parser.parse_args()
+
+sources = None if args.sources is None else {int(s, 0) for s in args.sources.split(",")}
+
+with open(Path(args.input), "rb") as log_file:
+    if log_file.read(len(MAGIC)) != MAGIC:
+        raise SystemExit("{} is not a simulator log".format(args.input))
+
+    for chunk in iter(lambda: log_file.read(RECORD.size), b""):
+        if len(chunk) != RECORD.size:
+            break
+
+        timestamp, a, b, source = RECORD.unpack(chunk)
+        if sources is not None and source not in sources:
+            continue
+
+        name, fmt = FORMATS.get(source, ("src {}".format(source), lambda a, b: "a = {:x}, b = {:x}".format(a, b)))
+        print("{:>10} [{}] {}".format(timestamp, name, fmt(a, b)))
@@ -0,0 +1,92 @@
+from argparse import ArgumentParser
+from pathlib import Path
+import struct
+
+# Converts recordings written by `video_capture::Writer` (simulator/video_capture/video_capture.hpp) to Y4M,
+# which ffmpeg and most video players read, e.g. `ffmpeg -i sim.y4m -c:v libx264 -crf 0 sim.mp4`
+
+MAGIC = b"VIDCAP01"
+PIXELS = 0
+REPEAT = 1
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if byte & 0x80 == 0:
+            return value, pos
+        shift += 7
+
+
+def to_yuv444(pixels):
+    # BT.601 full range, the 4 bit channels are scaled to 8 bits
+    y_plane = bytearray(len(pixels))
+    u_plane = bytearray(len(pixels))
+    v_plane = bytearray(len(pixels))
+    cache = {}
+    for i, color in enumerate(pixels):
+        yuv = cache.get(color)
+        if yuv is None:
+            r = (color >> 8 & 0xF) * 17
+            g = (color >> 4 & 0xF) * 17
+            b = (color & 0xF) * 17
+            y = 0.299 * r + 0.587 * g + 0.114 * b
+            yuv = (round(y), round(128 + (b - y) * 0.564), round(128 + (r - y) * 0.713))
+            yuv = tuple(min(255, max(0, c)) for c in yuv)
+            cache[color] = yuv
+        y_plane[i], u_plane[i], v_plane[i] = yuv
+    return bytes(y_plane + u_plane + v_plane)
+
+
+parser = ArgumentParser(description="Converts simulator video recordings to Y4M")
+parser.add_argument("input", help="Path to the recording")
+parser.add_argument("--output", dest="out_file", default=None, help="Output path")
+parser.add_argument("--fps", dest="fps", type=int, default=60, help="Frame rate written to the header")
+
+args = parser.parse_args()
+
+in_path = Path(args.input)
+out_path = Path(args.out_file) if args.out_file is not None else in_path.with_suffix(".y4m")
+
+data = in_path.read_bytes()
+if data[:len(MAGIC)] != MAGIC:
+    raise SystemExit("{} is not a simulator video recording".format(args.input))
+
+width, height = struct.unpack_from("<HH", data, len(MAGIC))
+pos = len(MAGIC) + 4
+frame_size = width * height
+
+with open(out_path, "wb") as out_file:
+    out_file.write("YUV4MPEG2 W{} H{} F{}:1 Ip A1:1 C444\n".format(width, height, args.fps).encode())
+
+    frames = 0
+    dropped = 0
+    encoded = None
+    while pos < len(data):
+        delta, pos = read_varint(data, pos)
+        kind = data[pos]
+        pos += 1
+
+        if kind == PIXELS:
+            pixels = []
+            while len(pixels) < frame_size:
+                run, pos = read_varint(data, pos)
+                color, = struct.unpack_from("<H", data, pos)
+                pos += 2
+                pixels.extend([color] * run)
+            encoded = to_yuv444(pixels)
+        elif kind != REPEAT or encoded is None:
+            raise SystemExit("{} is corrupt".format(args.input))
+
+        # dropped frames are filled with the last frame so the timing stays right
+        for _ in range(delta if frames > 0 else 1):
+            out_file.write(b"FRAME\n")
+            out_file.write(encoded)
+        dropped += delta - 1 if frames > 0 else 0
+        frames += 1
+
+print("{} frames written to {}, {} dropped frames filled in".format(frames, out_path, dropped))